@@ -0,0 +1,509 @@
+// 帧回放基准：把录好的灰度 / RGB565 / JPEG 帧喂给固件里同一套分析函数，
+// 统计每帧各阶段耗时和吞吐，CI 里可以用 --max-avg-us 卡性能回退
+//
+//   line_replay [选项] <gray|rgb565|jpeg> <宽> <高> [文件...]
+//
+// gray / rgb565 文件是连续的原始帧（RGB565 为相机的大端字节序），
+// jpeg 文件可以是单张，也可以是多张首尾相接（例如 /stream 去掉 multipart 头后的数据）
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "line_track.h"
+#include "line_predict.h"
+#include "auto_threshold.h"
+#include "bin_image.h"
+#include "line_fit.h"
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+} replay_frame_t;
+
+typedef enum {
+    STAGE_CONVERT,      // 转灰度（JPEG 含解码）
+    STAGE_ANALYZE,      // 巡线 + 自适应阈值，同 analyze_frame_gray
+    STAGE_MORPH,        // 可选：阈值打包成 1bpp + 开运算
+    STAGE_FIT,          // 可选：二值图取段中点 + Hough/RANSAC 拟合
+    STAGE_ENCODE,       // 可选：/stream 用的 frame2jpg_cb
+    STAGE_TOTAL,
+    STAGE_MAX,
+} replay_stage_t;
+
+static const char *s_stage_names[STAGE_MAX] = { "convert", "analyze", "morph", "fit", "encode", "total" };
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void print_usage(void)
+{
+    fprintf(stderr,
+            "usage: line_replay [options] <gray|rgb565|jpeg> <width> <height> [file...]\n"
+            "  --synthetic N    generate N frames of a drifting line instead of reading files\n"
+            "  --loop N         replay the frames N times (default 1)\n"
+            "  --morph          also threshold-pack to 1bpp and run a 3x3 open\n"
+            "  --fit            also fit the line with Hough/RANSAC on the 1bpp image\n"
+            "  --predict        scan only a predicted window around the line, like the firmware\n"
+            "  --encode Q       also JPEG-encode each raw frame at quality Q, like /stream\n"
+            "  --csv            print one CSV line per frame\n"
+            "  --max-avg-us N   exit with status 2 if the average total time exceeds N us\n");
+}
+
+static bool parse_format(const char *s, pixformat_t *fmt)
+{
+    if (!strcmp(s, "gray")) {
+        *fmt = PIXFORMAT_GRAYSCALE;
+    } else if (!strcmp(s, "rgb565")) {
+        *fmt = PIXFORMAT_RGB565;
+    } else if (!strcmp(s, "jpeg")) {
+        *fmt = PIXFORMAT_JPEG;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = n > 0 ? malloc(n) : NULL;
+    if (buf && fread(buf, 1, n, f) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = buf ? (size_t)n : 0;
+    return buf;
+}
+
+static bool push_frame(replay_frame_t **frames, int *count, int *cap, const uint8_t *src, size_t len)
+{
+    if (*count == *cap) {
+        int ncap = *cap ? *cap * 2 : 64;
+        replay_frame_t *n = realloc(*frames, ncap * sizeof(replay_frame_t));
+        if (!n) {
+            return false;
+        }
+        *frames = n;
+        *cap = ncap;
+    }
+    uint8_t *buf = malloc(len);
+    if (!buf) {
+        return false;
+    }
+    memcpy(buf, src, len);
+    (*frames)[*count].buf = buf;
+    (*frames)[*count].len = len;
+    (*count)++;
+    return true;
+}
+
+// 多张 JPEG 首尾相接时按 EOI(FFD9) 紧跟 SOI(FFD8) 切分
+static size_t next_jpeg_end(const uint8_t *p, size_t len)
+{
+    for (size_t i = 2; i + 3 < len; ++i) {
+        if (p[i] == 0xFF && p[i + 1] == 0xD9 && p[i + 2] == 0xFF && p[i + 3] == 0xD8) {
+            return i + 2;
+        }
+    }
+    return len;
+}
+
+static bool load_file(const char *path, pixformat_t fmt, size_t frame_len,
+                      replay_frame_t **frames, int *count, int *cap)
+{
+    size_t len = 0;
+    uint8_t *data = read_file(path, &len);
+    if (!data) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+    bool ok = true;
+    size_t pos = 0;
+    while (ok && pos < len) {
+        size_t n;
+        if (fmt == PIXFORMAT_JPEG) {
+            n = next_jpeg_end(data + pos, len - pos);
+        } else {
+            if (len - pos < frame_len) {
+                fprintf(stderr, "%s: %zu trailing bytes ignored\n", path, len - pos);
+                break;
+            }
+            n = frame_len;
+        }
+        ok = push_frame(frames, count, cap, data + pos, n);
+        pos += n;
+    }
+    free(data);
+    return ok;
+}
+
+// 合成帧：浅色带噪声的地面上一条倾斜、左右摆动的黑线；expect 给出最底行线中心
+static void synth_gray(uint8_t *gray, int w, int h, int idx, float *expect_x_bottom)
+{
+    static uint32_t seed = 12345;
+    const float line_w = w / 16.0f;
+    const float drift = (float)((idx % 40) - 20) / 20.0f;      // -1 .. 1 往复
+    const float x_bottom = w * 0.5f + drift * w * 0.25f;
+    const float slope = drift * 0.3f;                           // 往上走时向中间收
+    for (int y = 0; y < h; ++y) {
+        const float cx = x_bottom + slope * (y - (h - 1));
+        for (int x = 0; x < w; ++x) {
+            seed = seed * 1103515245u + 12345u;
+            const int noise = (int)((seed >> 16) & 15) - 8;
+            const bool dark = x >= cx - line_w / 2 && x < cx + line_w / 2;
+            gray[y * w + x] = (uint8_t)((dark ? 40 : 180) + noise);
+        }
+    }
+    *expect_x_bottom = x_bottom;
+}
+
+static bool synth_frames(pixformat_t fmt, int w, int h, int n, replay_frame_t **frames, int *count, int *cap, float *expect)
+{
+    uint8_t *gray = malloc((size_t)w * h);
+    uint8_t *rgb = malloc((size_t)w * h * 2);
+    bool ok = gray && rgb;
+    for (int i = 0; ok && i < n; ++i) {
+        synth_gray(gray, w, h, i, &expect[i]);
+        if (fmt == PIXFORMAT_GRAYSCALE) {
+            ok = push_frame(frames, count, cap, gray, (size_t)w * h);
+        } else if (fmt == PIXFORMAT_RGB565) {
+            for (int p = 0; p < w * h; ++p) {
+                const uint8_t v = gray[p];
+                const uint16_t c = (uint16_t)(((v >> 3) << 11) | ((v >> 2) << 5) | (v >> 3));
+                rgb[p * 2] = c >> 8;
+                rgb[p * 2 + 1] = c & 0xFF;
+            }
+            ok = push_frame(frames, count, cap, rgb, (size_t)w * h * 2);
+        } else {
+            uint8_t *jpg = NULL;
+            size_t jpg_len = 0;
+            ok = fmt2jpg(gray, (size_t)w * h, w, h, PIXFORMAT_GRAYSCALE, 80, &jpg, &jpg_len)
+                 && push_frame(frames, count, cap, jpg, jpg_len);
+            free(jpg);
+        }
+    }
+    free(gray);
+    free(rgb);
+    return ok;
+}
+
+// 相机 RGB565 是大端；jpg2rgb565 输出小端
+static void rgb565_to_gray(const uint8_t *src, uint8_t *gray, int pixels, bool big_endian)
+{
+    for (int i = 0; i < pixels; ++i) {
+        const uint16_t c = big_endian ? (uint16_t)(src[2 * i] << 8 | src[2 * i + 1])
+                                      : (uint16_t)(src[2 * i + 1] << 8 | src[2 * i]);
+        const uint32_t r = (c >> 11) << 3, g = ((c >> 5) & 0x3F) << 2, b = (c & 0x1F) << 3;
+        gray[i] = (uint8_t)((r * 77 + g * 150 + b * 29) >> 8);
+    }
+}
+
+static bool jpeg_to_gray(const replay_frame_t *f, int w, int h, uint8_t *rgb, uint8_t *gray)
+{
+    // jpg2rgb565 不检查输出缓冲大小，先确认尺寸
+    esp_jpeg_image_cfg_t cfg = {
+        .indata = f->buf,
+        .indata_size = f->len,
+    };
+    esp_jpeg_image_output_t info = { 0 };
+    if (esp_jpeg_get_image_info(&cfg, &info) != ESP_OK || info.width != w || info.height != h) {
+        return false;
+    }
+    if (!jpg2rgb565(f->buf, f->len, rgb, JPEG_IMAGE_SCALE_0)) {
+        return false;
+    }
+    rgb565_to_gray(rgb, gray, w * h, false);
+    return true;
+}
+
+static size_t count_bytes(void *arg, size_t index, const void *data, size_t len)
+{
+    (void)index;
+    (void)data;
+    *(size_t *)arg += len;
+    return len;
+}
+
+int main(int argc, char **argv)
+{
+    int synthetic = 0, loops = 1, encode_q = 0;
+    long max_avg_us = 0;
+    bool csv = false, morph = false, fit = false, predict = false;
+
+    // 选项可以出现在任意位置，其余按顺序为 格式 宽 高 文件...
+    const char **pos = calloc(argc, sizeof(char *));
+    int npos = 0;
+    for (int i = 1; i < argc; ++i) {
+        const char *opt = argv[i];
+        const bool has_val = i + 1 < argc;
+        if (strncmp(opt, "--", 2)) {
+            pos[npos++] = opt;
+        } else if (!strcmp(opt, "--synthetic") && has_val) {
+            synthetic = atoi(argv[++i]);
+        } else if (!strcmp(opt, "--loop") && has_val) {
+            loops = atoi(argv[++i]);
+        } else if (!strcmp(opt, "--encode") && has_val) {
+            encode_q = atoi(argv[++i]);
+        } else if (!strcmp(opt, "--max-avg-us") && has_val) {
+            max_avg_us = atol(argv[++i]);
+        } else if (!strcmp(opt, "--morph")) {
+            morph = true;
+        } else if (!strcmp(opt, "--fit")) {
+            fit = true;
+        } else if (!strcmp(opt, "--predict")) {
+            predict = true;
+        } else if (!strcmp(opt, "--csv")) {
+            csv = true;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    pixformat_t fmt;
+    if (npos < 3 || !parse_format(pos[0], &fmt)) {
+        print_usage();
+        return 1;
+    }
+    const int w = atoi(pos[1]);
+    const int h = atoi(pos[2]);
+    if (w <= 0 || h <= 0 || w > 4096 || h > 4096 || loops <= 0 || encode_q < 0 || encode_q > 100
+        || (!synthetic && npos == 3)) {
+        print_usage();
+        return 1;
+    }
+    const size_t frame_len = (size_t)w * h * (fmt == PIXFORMAT_RGB565 ? 2 : 1);
+
+    replay_frame_t *frames = NULL;
+    int count = 0, cap = 0;
+    float *expect = NULL;
+    if (synthetic) {
+        expect = calloc(synthetic, sizeof(float));
+        if (!expect || !synth_frames(fmt, w, h, synthetic, &frames, &count, &cap, expect)) {
+            fprintf(stderr, "synthetic frame generation failed\n");
+            return 1;
+        }
+    } else {
+        for (int i = 3; i < npos; ++i) {
+            if (!load_file(pos[i], fmt, frame_len, &frames, &count, &cap)) {
+                return 1;
+            }
+        }
+    }
+    if (count == 0) {
+        fprintf(stderr, "no frames\n");
+        return 1;
+    }
+
+    // 和 analyze_frame_gray 一样的配置
+    static uint32_t hist[256];
+    line_track_config_t cfg;
+    line_track_result_t res;
+    auto_threshold_t at;
+    line_track_default_config(&cfg, w, h, 8);
+    cfg.hist = hist;
+    auto_threshold_init(&at, AUTO_TH_OTSU, cfg.threshold);
+    line_predict_t lp;
+    line_predict_init(&lp, &cfg);
+    uint64_t pixels = 0;
+
+    uint8_t *gray = malloc((size_t)w * h);
+    uint8_t *rgb = malloc((size_t)w * h * 2);
+    const int total = count * loops;
+    uint32_t *samples[STAGE_MAX];
+    for (int s = 0; s < STAGE_MAX; ++s) {
+        samples[s] = calloc(total, sizeof(uint32_t));
+        if (!samples[s]) {
+            return 1;
+        }
+    }
+    uint32_t *bits = malloc(bin_image_words(w, h) * sizeof(uint32_t));
+    bin_image_t bin;
+    if (!gray || !rgb || !bits || ((morph || fit) && !bin_image_init(&bin, w, h, bits))) {
+        return 1;
+    }
+    static line_fit_t lf;
+    static line_fit_point_t fit_pts[LINE_FIT_MAX_POINTS];
+    line_fit_result_t fit_res = { 0 };
+    line_fit_init(&lf, w, h);
+    int fit_found = 0;
+
+    bool stage_on[STAGE_MAX] = { true, true, morph || fit, fit, encode_q && fmt != PIXFORMAT_JPEG, true };
+    if (csv) {
+        printf("frame");
+        for (int s = 0; s < STAGE_MAX; ++s) {
+            if (stage_on[s]) {
+                printf(",%s_ns", s_stage_names[s]);
+            }
+        }
+        printf(",valid,rows,offset,heading,th,pixels,jpg_bytes\n");
+    }
+
+    int found = 0, mismatched = 0, failed = 0;
+    const uint64_t run_start = now_ns();
+    for (int n = 0; n < total; ++n) {
+        const replay_frame_t *f = &frames[n % count];
+
+        uint64_t t[STAGE_MAX + 1];
+        t[STAGE_CONVERT] = now_ns();
+        const uint8_t *img = gray;
+        bool ok = true;
+        if (fmt == PIXFORMAT_GRAYSCALE) {
+            img = f->buf;
+        } else if (fmt == PIXFORMAT_RGB565) {
+            rgb565_to_gray(f->buf, gray, w * h, true);
+        } else {
+            ok = jpeg_to_gray(f, w, h, rgb, gray);
+        }
+        t[STAGE_ANALYZE] = now_ns();
+
+        if (ok) {
+            if (predict) {
+                line_predict_process(&lp, &cfg, img, &res);
+            } else {
+                line_track_process(&cfg, img, &res);
+            }
+            pixels += res.pixels;
+            cfg.threshold = auto_threshold_update(&at, hist);
+        } else {
+            failed++;
+            memset(&res, 0, sizeof(res));
+        }
+        t[STAGE_MORPH] = now_ns();
+
+        if (stage_on[STAGE_MORPH] && ok) {
+            bin_image_threshold(&bin, img, 0, cfg.threshold);
+            if (morph) {
+                bin_image_open(&bin, &bin);
+            }
+        }
+        t[STAGE_FIT] = now_ns();
+
+        if (fit && ok) {
+            const int np = line_fit_run_centers(&bin, 1, cfg.min_width, cfg.max_width, fit_pts, LINE_FIT_MAX_POINTS);
+            fit_found += line_fit_run(&lf, fit_pts, np, &fit_res);
+        }
+        t[STAGE_ENCODE] = now_ns();
+
+        size_t jpg_bytes = 0;
+        if (stage_on[STAGE_ENCODE]) {
+            camera_fb_t fb = {
+                .buf = f->buf,
+                .len = f->len,
+                .width = w,
+                .height = h,
+                .format = fmt,
+            };
+            frame2jpg_cb(&fb, encode_q, count_bytes, &jpg_bytes);
+        }
+        t[STAGE_TOTAL] = now_ns();
+
+        for (int s = 0; s < STAGE_TOTAL; ++s) {
+            samples[s][n] = (uint32_t)(t[s + 1] - t[s]);
+        }
+        samples[STAGE_TOTAL][n] = (uint32_t)(t[STAGE_TOTAL] - t[STAGE_CONVERT]);
+
+        if (res.valid) {
+            found++;
+        }
+        // 合成帧知道真值：最底扫描行处的拟合中心应在半个线宽以内
+        if (expect) {
+            const float x = res.intercept + res.slope * cfg.rows[cfg.row_count - 1];
+            if (!res.valid || x < expect[n % count] - w / 32.0f || x > expect[n % count] + w / 32.0f) {
+                mismatched++;
+            }
+        }
+        if (csv) {
+            printf("%d", n);
+            for (int s = 0; s < STAGE_MAX; ++s) {
+                if (stage_on[s]) {
+                    printf(",%u", samples[s][n]);
+                }
+            }
+            printf(",%d,%d,%.3f,%.3f,%d,%u,%zu\n", res.valid, res.rows_found, res.offset, res.heading, cfg.threshold,
+                   res.pixels, jpg_bytes);
+        }
+    }
+    const double run_s = (now_ns() - run_start) / 1e9;
+
+    FILE *out = csv ? stderr : stdout;
+    static const char *fmt_names[] = { [PIXFORMAT_GRAYSCALE] = "gray", [PIXFORMAT_RGB565] = "rgb565", [PIXFORMAT_JPEG] = "jpeg" };
+    fprintf(out, "%d frames (%d unique) %dx%d %s, line found in %d, decode failures %d\n",
+            total, count, w, h, fmt_names[fmt], found, failed);
+    fprintf(out, "%-8s %10s %10s %10s %10s  (us)\n", "stage", "min", "avg", "p99", "max");
+    double avg_total_us = 0;
+    for (int s = 0; s < STAGE_MAX; ++s) {
+        if (!stage_on[s]) {
+            continue;
+        }
+        uint64_t sum = 0;
+        for (int n = 0; n < total; ++n) {
+            sum += samples[s][n];
+        }
+        qsort(samples[s], total, sizeof(uint32_t), cmp_u32);
+        const double avg_us = sum / 1000.0 / total;
+        fprintf(out, "%-8s %10.2f %10.2f %10.2f %10.2f\n", s_stage_names[s],
+                samples[s][0] / 1000.0, avg_us, samples[s][(total * 99 + 99) / 100 - 1] / 1000.0,
+                samples[s][total - 1] / 1000.0);
+        if (s == STAGE_TOTAL) {
+            avg_total_us = avg_us;
+        }
+    }
+    fprintf(out, "scan: %.0f px/frame", (double)pixels / total);
+    if (predict) {
+        fprintf(out, ", window half=%u, rescans=%u", lp.half, lp.rescans);
+    }
+    fprintf(out, "\n");
+    if (fit) {
+        fprintf(out, "hough/ransac fit found the line in %d frames\n", fit_found);
+    }
+    fprintf(out, "throughput: %.1f frames/s\n", total / run_s);
+
+    int ret = 0;
+    if (failed) {
+        ret = 1;
+    }
+    if (expect && mismatched) {
+        fprintf(stderr, "synthetic: %d of %d frames missed the line\n", mismatched, total);
+        ret = 1;
+    }
+    if (max_avg_us && avg_total_us > max_avg_us) {
+        fprintf(stderr, "average %.2f us exceeds --max-avg-us %ld\n", avg_total_us, max_avg_us);
+        ret = 2;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        free(frames[i].buf);
+    }
+    for (int s = 0; s < STAGE_MAX; ++s) {
+        free(samples[s]);
+    }
+    free(frames);
+    free(expect);
+    free(pos);
+    free(gray);
+    free(rgb);
+    free(bits);
+    return ret;
+}
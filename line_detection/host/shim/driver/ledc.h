@@ -0,0 +1,8 @@
+#pragma once
+
+// esp_camera.h 的 camera_config_t 引用了 LEDC 类型，主机上只需要类型本身
+typedef int ledc_timer_t;
+typedef int ledc_channel_t;
+
+#define LEDC_TIMER_0    0
+#define LEDC_CHANNEL_0  0
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_DEFAULT  (1 << 0)
+#define MALLOC_CAP_8BIT     (1 << 1)
+#define MALLOC_CAP_DMA      (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 4)
+
+#define heap_caps_malloc(size, caps)            malloc(size)
+#define heap_caps_calloc(n, size, caps)         calloc(n, size)
+#define heap_caps_aligned_alloc(a, size, caps)  aligned_alloc(a, ((size) + (a) - 1) / (a) * (a))
+#define heap_caps_free(p)                       free(p)
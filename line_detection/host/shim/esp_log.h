@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// 不加 printf 格式检查：上游 conversions 里有 %u 配 size_t 之类的写法，主机构建要保持零告警
+static inline void esp_log_shim(const char *level, const char *tag, const char *fmt, ...)
+{
+    va_list ap;
+    fprintf(stderr, "%s %s: ", level, tag);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+// 主机上只把错误和警告打到 stderr，信息级日志会干扰计时输出；
+// 不打印的级别也引用一下参数，和 IDF 一样不会冒出“变量未使用”
+#define ESP_LOGE(tag, fmt, ...) esp_log_shim("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) esp_log_shim("W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) do { if (0) esp_log_shim("I", tag, fmt, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, fmt, ...) do { if (0) esp_log_shim("D", tag, fmt, ##__VA_ARGS__); } while (0)
+#define ESP_LOGV(tag, fmt, ...) do { if (0) esp_log_shim("V", tag, fmt, ##__VA_ARGS__); } while (0)
@@ -0,0 +1,8 @@
+#pragma once
+
+// 主机构建占位：IDF 的 FreeRTOS.h 会间接带进这些头，被包含的源码依赖这一点
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "esp_heap_caps.h"
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+// 主机构建占位：vTaskDelay 由用到它的测试自己实现（一般是计数，不真的睡）
+#define portTICK_PERIOD_MS 1
+
+void vTaskDelay(uint32_t ticks);
@@ -0,0 +1,11 @@
+#pragma once
+
+// 主机构建用的 sdkconfig：只放 conversions / esp_jpeg 用到的项
+// 目标板上 JPEG 解码走 ROM 里的 tjpgd，主机上编译 managed_components 里的源码版本
+
+#define CONFIG_JD_USE_ROM       0
+#define CONFIG_JD_SZBUF         512
+#define CONFIG_JD_FORMAT        0
+#define CONFIG_JD_USE_SCALE     1
+#define CONFIG_JD_TBLCLIP       1
+#define CONFIG_JD_FASTDECODE    1
@@ -0,0 +1,3 @@
+#pragma once
+
+// 主机构建占位：被包含但主机代码路径用不到其中内容
@@ -0,0 +1,118 @@
+// bin_image 与逐像素 8bit 参考实现对拍：随机图、各种宽度（含不满 32 位的尾字）、就地运算
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bin_image.h"
+
+#define MAX_W 160
+#define MAX_H 24
+
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return s_seed >> 16;
+}
+
+// 参考：图像外对腐蚀视为 1，对膨胀视为 0
+static void ref_morph(uint8_t *dst, const uint8_t *src, int w, int h, bool erode)
+{
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            int v = erode ? 1 : 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    const int yy = y + dy, xx = x + dx;
+                    if (yy < 0 || yy >= h || xx < 0 || xx >= w) {
+                        continue;
+                    }
+                    v = erode ? (v & src[yy * w + xx]) : (v | src[yy * w + xx]);
+                }
+            }
+            dst[y * w + x] = (uint8_t)v;
+        }
+    }
+}
+
+static int compare(const bin_image_t *b, const uint8_t *ref, const char *what, int w, int h)
+{
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            if (bin_image_get(b, x, y) != ref[y * w + x]) {
+                printf("FAIL %s %dx%d at (%d,%d)\n", what, w, h, x, y);
+                return 1;
+            }
+        }
+        // 填充位必须保持 0
+        const int used = w & 31;
+        if (used && (b->bits[(size_t)y * b->words_per_row + b->words_per_row - 1] >> used)) {
+            printf("FAIL %s %dx%d padding bits set in row %d\n", what, w, h, y);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    static const int widths[] = { 1, 5, 31, 32, 33, 64, 70, 160 };
+    static uint8_t gray[MAX_W * MAX_H];
+    static uint8_t mask[MAX_W * MAX_H], ref[MAX_W * MAX_H], tmp[MAX_W * MAX_H];
+    static uint32_t bits_a[(MAX_W + 31) / 32 * MAX_H], bits_b[(MAX_W + 31) / 32 * MAX_H];
+    int fails = 0;
+
+    for (size_t wi = 0; wi < sizeof(widths) / sizeof(widths[0]); ++wi) {
+        for (int h = 1; h <= MAX_H; h += 7) {
+            const int w = widths[wi];
+            for (int round = 0; round < 20; ++round) {
+                // 不同密度的噪声，既有孤立点也有大块
+                const uint32_t density = 32 + rnd() % 192;
+                for (int i = 0; i < w * h; ++i) {
+                    gray[i] = (uint8_t)rnd();
+                    mask[i] = gray[i] < density;
+                }
+
+                bin_image_t a, b;
+                bin_image_init(&a, w, h, bits_a);
+                bin_image_init(&b, w, h, bits_b);
+                bin_image_threshold(&a, gray, 0, (uint8_t)density);
+                fails += compare(&a, mask, "threshold", w, h);
+
+                ref_morph(ref, mask, w, h, true);
+                bin_image_erode(&b, &a);
+                fails += compare(&b, ref, "erode", w, h);
+
+                ref_morph(ref, mask, w, h, false);
+                bin_image_dilate(&b, &a);
+                fails += compare(&b, ref, "dilate", w, h);
+
+                ref_morph(tmp, mask, w, h, true);
+                ref_morph(ref, tmp, w, h, false);
+                bin_image_open(&b, &a);
+                fails += compare(&b, ref, "open", w, h);
+
+                ref_morph(tmp, mask, w, h, false);
+                ref_morph(ref, tmp, w, h, true);
+                bin_image_close(&a, &a);
+                fails += compare(&a, ref, "close in place", w, h);
+
+                int cnt = 0;
+                for (int x = 0; x < w; ++x) {
+                    cnt += ref[x];
+                }
+                if (bin_image_row_count(&a, 0) != cnt) {
+                    printf("FAIL row_count %dx%d\n", w, h);
+                    fails++;
+                }
+                if (fails) {
+                    return 1;
+                }
+            }
+        }
+    }
+    printf("bin_image: all cases match\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+// ESP32 I2S DMA 过滤器：字宽版本与逐字节版本对拍（随机输入、各种长度含 highspeed 尾巴、
+// dst 对齐/不对齐、就地转换），再各跑一遍测每输入字节耗时
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ll_cam_dma_filter.h"
+
+#define MAX_ELEMS 1024
+#define BENCH_LEN (4092 * 2)
+#define BENCH_ROUNDS 2000
+
+typedef struct {
+    const char *name;
+    dma_filter_t byte;
+    dma_filter_t word;
+} filter_pair_t;
+
+static const filter_pair_t s_filters[] = {
+    { "jpeg", ll_cam_dma_filter_jpeg, ll_cam_dma_filter_jpeg_word },
+    { "grayscale", ll_cam_dma_filter_grayscale, ll_cam_dma_filter_grayscale_word },
+    { "grayscale_highspeed", ll_cam_dma_filter_grayscale_highspeed, ll_cam_dma_filter_grayscale_highspeed_word },
+    { "yuyv", ll_cam_dma_filter_yuyv, ll_cam_dma_filter_yuyv_word },
+    { "yuyv_highspeed", ll_cam_dma_filter_yuyv_highspeed, ll_cam_dma_filter_yuyv_highspeed_word },
+};
+
+#define FILTER_CNT (sizeof(s_filters) / sizeof(s_filters[0]))
+
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return s_seed >> 16;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// 输出最多 2 字节/元素，末尾再留 8 字节给尾巴写入和不对齐偏移
+static uint32_t s_src[MAX_ELEMS];
+static uint32_t s_out_a[MAX_ELEMS / 2 + 4], s_out_b[MAX_ELEMS / 2 + 4];
+static uint32_t s_inplace_a[MAX_ELEMS + 4], s_inplace_b[MAX_ELEMS + 4];
+
+static int check_one(const filter_pair_t *f, size_t elems, size_t offset)
+{
+    const size_t len = elems * sizeof(uint32_t);
+    for (size_t i = 0; i < elems; ++i) {
+        s_src[i] = (rnd() << 16) ^ rnd();
+    }
+
+    // 独立输出：两份输出预填同样的垃圾，未写到的字节也必须一致
+    memset(s_out_a, 0xa5, sizeof(s_out_a));
+    memset(s_out_b, 0xa5, sizeof(s_out_b));
+    const size_t ra = f->byte((uint8_t *)s_out_a + offset, (const uint8_t *)s_src, len);
+    const size_t rb = f->word((uint8_t *)s_out_b + offset, (const uint8_t *)s_src, len);
+    if (ra != rb || memcmp(s_out_a, s_out_b, sizeof(s_out_a)) != 0) {
+        printf("FAIL %s elems=%zu dst+%zu: byte/word output differs\n", f->name, elems, offset);
+        return 1;
+    }
+
+    // 就地：cam_hal 的 slice-only 模式直接在 DMA 半缓冲里转换
+    memset(s_inplace_a, 0, sizeof(s_inplace_a));
+    memcpy(s_inplace_a, s_src, len);
+    memcpy(s_inplace_b, s_inplace_a, sizeof(s_inplace_a));
+    f->byte((uint8_t *)s_inplace_a, (const uint8_t *)s_inplace_a, len);
+    f->word((uint8_t *)s_inplace_b, (const uint8_t *)s_inplace_b, len);
+    if (memcmp(s_inplace_a, s_inplace_b, sizeof(s_inplace_a)) != 0) {
+        printf("FAIL %s elems=%zu in place: byte/word output differs\n", f->name, elems);
+        return 1;
+    }
+    return 0;
+}
+
+static double bench(dma_filter_t fn, uint8_t *dst, const uint8_t *src)
+{
+    size_t sink = 0;
+    const double t0 = now_ns();
+    for (int i = 0; i < BENCH_ROUNDS; ++i) {
+        sink += fn(dst, src, BENCH_LEN);
+    }
+    const double t1 = now_ns();
+    if (sink == 0) {
+        printf("bench: no output\n");
+    }
+    return (t1 - t0) / ((double)BENCH_ROUNDS * BENCH_LEN);
+}
+
+int main(void)
+{
+    int fails = 0;
+
+    for (size_t fi = 0; fi < FILTER_CNT; ++fi) {
+        for (size_t elems = 0; elems <= 72; ++elems) {
+            for (size_t offset = 0; offset < 4; ++offset) {
+                fails += check_one(&s_filters[fi], elems, offset);
+            }
+        }
+        // 一个整 DMA 节点的量，highspeed 模式下每行末尾会少/多一个元素
+        fails += check_one(&s_filters[fi], 1023, 0);
+        fails += check_one(&s_filters[fi], 1022, 0);
+        fails += check_one(&s_filters[fi], 1020, 0);
+        if (fails) {
+            return 1;
+        }
+    }
+    printf("dma_filter: word filters match byte filters\n");
+
+    // 主机上的耗时只看相对值，目标板上的 cycles/byte 用 esp_cpu_get_cycle_count() 另测
+    static uint32_t src[BENCH_LEN / 4], dst[BENCH_LEN / 2];
+    for (size_t i = 0; i < BENCH_LEN / 4; ++i) {
+        src[i] = (rnd() << 16) ^ rnd();
+    }
+    for (size_t fi = 0; fi < FILTER_CNT; ++fi) {
+        const double nb = bench(s_filters[fi].byte, (uint8_t *)dst, (const uint8_t *)src);
+        const double nw = bench(s_filters[fi].word, (uint8_t *)dst, (const uint8_t *)src);
+        printf("%-20s byte %.3f ns/B  word %.3f ns/B  x%.2f\n", s_filters[fi].name, nb, nw, nb / nw);
+    }
+    return 0;
+}
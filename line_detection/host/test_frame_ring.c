@@ -0,0 +1,137 @@
+// frame_ring：LATEST 模式队列满时丢最旧的帧、新帧必须入队；DROP_NEWEST 丢新帧；
+// 再用两个线程对压，每一帧都要恰好被取走或归还一次，取到的帧序号只增不减
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "frame_ring.h"
+
+#define STRESS_ITEMS 200000
+
+// 帧用 1..N 的序号代替指针
+#define ITEM(n) ((void *)(uintptr_t)(n))
+#define ID(p)   ((uint32_t)(uintptr_t)(p))
+
+static uint8_t s_released[STRESS_ITEMS + 1];
+static uint8_t s_popped[STRESS_ITEMS + 1];
+static int s_fails;
+
+static void release_cb(void *item, void *arg)
+{
+    (void)arg;
+    s_released[ID(item)]++;
+}
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        s_fails++;
+    }
+}
+
+static void reset_marks(void)
+{
+    memset(s_released, 0, sizeof(s_released));
+    memset(s_popped, 0, sizeof(s_popped));
+}
+
+static void test_latest(uint32_t depth)
+{
+    frame_ring_t ring;
+    frame_ring_stats_t st;
+    reset_marks();
+    frame_ring_init(&ring, depth, FRAME_RING_LATEST, release_cb, NULL);
+    // 多塞一帧：最旧的 1 号被顶掉，新帧入队成功
+    for (uint32_t i = 1; i <= depth + 1; ++i) {
+        check(frame_ring_push(&ring, ITEM(i)), "latest push accepted");
+    }
+    check(s_released[1] == 1 && s_released[depth + 1] == 0, "latest full drops the oldest");
+    check(ID(frame_ring_pop(&ring)) == depth + 1, "latest pop returns the newest");
+    check(frame_ring_pop(&ring) == NULL, "latest empty after pop");
+    for (uint32_t i = 1; i <= depth; ++i) {
+        check(s_released[i] == 1, "latest stale frames released once");
+    }
+    frame_ring_get_stats(&ring, &st);
+    check(st.pushed == depth + 1 && st.popped == 1 && st.dropped_full == 0 && st.dropped_stale == depth,
+          "latest stats");
+}
+
+static void test_drop_newest(void)
+{
+    frame_ring_t ring;
+    frame_ring_stats_t st;
+    reset_marks();
+    frame_ring_init(&ring, 2, FRAME_RING_DROP_NEWEST, release_cb, NULL);
+    check(frame_ring_push(&ring, ITEM(1)) && frame_ring_push(&ring, ITEM(2)), "drop_newest push");
+    check(!frame_ring_push(&ring, ITEM(3)) && s_released[3] == 1, "drop_newest full drops the new frame");
+    check(ID(frame_ring_pop(&ring)) == 1 && ID(frame_ring_pop(&ring)) == 2, "drop_newest keeps order");
+    frame_ring_get_stats(&ring, &st);
+    check(st.dropped_full == 1 && st.dropped_stale == 0, "drop_newest stats");
+
+    check(frame_ring_push(&ring, ITEM(4)) && frame_ring_push(&ring, ITEM(5)), "drain push");
+    frame_ring_drain(&ring);
+    check(s_released[4] == 1 && s_released[5] == 1 && frame_ring_count(&ring) == 0, "drain releases all");
+}
+
+static frame_ring_t s_stress_ring;
+
+static void *producer(void *arg)
+{
+    (void)arg;
+    for (uint32_t i = 1; i <= STRESS_ITEMS; ++i) {
+        frame_ring_push(&s_stress_ring, ITEM(i));
+        // 单核机器上不让一下，消费者几乎插不进来
+        if ((i & 3) == 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void test_stress(uint32_t depth)
+{
+    pthread_t th;
+    reset_marks();
+    frame_ring_init(&s_stress_ring, depth, FRAME_RING_LATEST, release_cb, NULL);
+    pthread_create(&th, NULL, producer, NULL);
+    uint32_t last = 0;
+    bool ordered = true;
+    // 最后一帧不会被顶掉，一定会被取到
+    while (last != STRESS_ITEMS) {
+        void *p = frame_ring_pop(&s_stress_ring);
+        if (!p) {
+            sched_yield();
+            continue;
+        }
+        ordered = ordered && ID(p) > last;
+        last = ID(p);
+        s_popped[last]++;
+    }
+    pthread_join(th, NULL);
+
+    uint32_t popped = 0;
+    bool once = true;
+    for (uint32_t i = 1; i <= STRESS_ITEMS; ++i) {
+        once = once && s_popped[i] + s_released[i] == 1;
+        popped += s_popped[i];
+    }
+    check(ordered, "stress pops in order");
+    check(once, "stress every frame popped or released exactly once");
+    printf("frame_ring stress depth %u: %u of %u frames popped\n", (unsigned)depth, (unsigned)popped,
+           (unsigned)STRESS_ITEMS);
+}
+
+int main(void)
+{
+    test_latest(1);
+    test_latest(2);
+    test_latest(FRAME_RING_MAX_CAP);
+    test_drop_newest();
+    test_stress(1);
+    test_stress(2);
+    return s_fails ? 1 : 0;
+}
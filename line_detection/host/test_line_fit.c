@@ -0,0 +1,137 @@
+// line_fit：主线 + 交叉线 + 随机反光点，检查拟合精度；再测 500 点一帧的耗时
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "line_fit.h"
+
+#define W 160
+#define H 120
+
+static uint32_t s_seed = 7;
+
+static int rnd(int n)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return (int)((s_seed >> 16) % n);
+}
+
+// 主线 x = a + b * y 占一半点，交叉线 3/10，其余是随机点
+static int make_points(line_fit_point_t *pts, int n, float a, float b)
+{
+    int k = 0;
+    for (int i = 0; i < n; ++i) {
+        const int kind = rnd(10);
+        int x, y = rnd(H);
+        if (kind < 5) {
+            x = (int)lroundf(a + b * y) + rnd(3) - 1;
+        } else if (kind < 8) {
+            x = (int)lroundf(20 + 1.8f * y) % W;       // 陡的交叉线，超出投票角度范围
+            if (y % 3) {
+                x = (int)lroundf(W - 1 - 0.9f * y);    // 另一条反向斜线
+            }
+        } else {
+            x = rnd(W);
+        }
+        if (x < 0 || x >= W) {
+            continue;
+        }
+        pts[k].x = (int16_t)x;
+        pts[k].y = (int16_t)y;
+        k++;
+    }
+    return k;
+}
+
+static int check(line_fit_t *lf, float a, float b, const char *what)
+{
+    static line_fit_point_t pts[500];
+    const int n = make_points(pts, 500, a, b);
+    line_fit_result_t r;
+    if (!line_fit_run(lf, pts, n, &r)) {
+        printf("FAIL %s: no line (peak %d)\n", what, r.peak_votes);
+        return 1;
+    }
+    const float x_mid = r.intercept + r.slope * (H / 2);
+    const float exp_mid = a + b * (H / 2);
+    if (fabsf(r.slope - b) > 0.03f || fabsf(x_mid - exp_mid) > 1.0f || r.confidence < 0.3f) {
+        printf("FAIL %s: slope %.3f (want %.3f) x_mid %.2f (want %.2f) conf %.2f\n",
+               what, r.slope, b, x_mid, exp_mid, r.confidence);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    static line_fit_t lf;
+    int fails = 0;
+
+    line_fit_init(&lf, W, H);
+    const float cases[][2] = { { 80, 0 }, { 40, 0.5f }, { 130, -0.6f }, { 10, 0.9f }, { 150, -0.95f } };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        lf.ransac_iters = 16;
+        fails += check(&lf, cases[i][0], cases[i][1], "ransac");
+        lf.ransac_iters = 0;
+        fails += check(&lf, cases[i][0], cases[i][1], "hough only");
+    }
+
+    // 没有线：全是随机点，峰值票数到不了门限
+    line_fit_point_t noise[40];
+    for (int i = 0; i < 40; ++i) {
+        noise[i].x = (int16_t)rnd(W);
+        noise[i].y = (int16_t)rnd(H);
+    }
+    line_fit_result_t r;
+    lf.min_votes = 20;
+    if (line_fit_run(&lf, noise, 40, &r)) {
+        printf("FAIL noise accepted (peak %d)\n", r.peak_votes);
+        fails++;
+    }
+
+    // 从二值图取段中点：宽 64（行尾段没有结束跳变）和 70（有填充位）
+    static uint32_t bits[3 * 4];
+    for (int w = 64; w <= 70; w += 6) {
+        bin_image_t img;
+        bin_image_init(&img, w, 4, bits);
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 10 + y; x < 16 + y; ++x) {
+                img.bits[y * img.words_per_row + x / 32] |= 1u << (x % 32);
+            }
+            for (int x = w - 8; x < w; ++x) {
+                img.bits[y * img.words_per_row + x / 32] |= 1u << (x % 32);
+            }
+        }
+        line_fit_point_t c[16];
+        const int n = line_fit_run_centers(&img, 1, 2, 7, c, 16);
+        if (n != 4 || c[0].x != 12 || c[3].x != 15 || c[3].y != 3) {
+            printf("FAIL run_centers w=%d: n=%d\n", w, n);
+            fails++;
+        }
+        const int n2 = line_fit_run_centers(&img, 1, 2, 8, c, 16);
+        if (n2 != 8 || c[1].x != w - 5) {
+            printf("FAIL run_centers tail w=%d: n=%d x=%d\n", w, n2, n2 > 1 ? c[1].x : -1);
+            fails++;
+        }
+    }
+
+    // 耗时：500 点，16 次 RANSAC
+    static line_fit_point_t pts[500];
+    const int n = make_points(pts, 500, 60, 0.2f);
+    line_fit_init(&lf, W, H);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < 1000; ++i) {
+        line_fit_run(&lf, pts, n, &r);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("line_fit: %d points, %.1f us per frame\n", n,
+           ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / 1000 / 1e3);
+
+    if (!fails) {
+        printf("line_fit: all cases pass\n");
+    }
+    return fails ? 1 : 0;
+}
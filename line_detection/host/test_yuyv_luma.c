@@ -0,0 +1,105 @@
+// ESP32-S3 YUYV 取 Y：字宽版本与逐字节版本对拍（各种长度、in/out 对齐与不对齐、就地），
+// 再各跑一遍测每输入字节耗时。ll_cam_luma.c 在这个目标里关掉自动向量化（见 CMakeLists），
+// 两边都是标量代码；但 x86 乱序多发射，逐字节的 4 读 4 写能并行，比值偏向逐字节。
+// LX7 顺序单发射，以目标板上 test_camera.c 的 [luma] 用例（esp_cpu_get_cycle_count）为准
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "ll_cam_luma.h"
+
+#define MAX_LEN 4096
+#define BENCH_LEN 7680          // QQVGA 一个 DMA 半缓冲的量级
+#define BENCH_ROUNDS 4000
+
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return s_seed >> 16;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t s_src[MAX_LEN / 4 + 2];
+static uint32_t s_out_a[MAX_LEN / 8 + 2], s_out_b[MAX_LEN / 8 + 2];
+static uint32_t s_inplace_a[MAX_LEN / 4 + 2], s_inplace_b[MAX_LEN / 4 + 2];
+
+static int check_one(size_t len, size_t in_off, size_t out_off)
+{
+    uint8_t *src = (uint8_t *)s_src + in_off;
+    for (size_t i = 0; i < sizeof(s_src); ++i) {
+        ((uint8_t *)s_src)[i] = (uint8_t)rnd();
+    }
+
+    memset(s_out_a, 0x5a, sizeof(s_out_a));
+    memset(s_out_b, 0x5a, sizeof(s_out_b));
+    const size_t ra = ll_cam_yuyv_to_y_bytes((uint8_t *)s_out_a + out_off, src, len);
+    const size_t rb = ll_cam_yuyv_to_y((uint8_t *)s_out_b + out_off, src, len);
+    if (ra != rb || memcmp(s_out_a, s_out_b, sizeof(s_out_a)) != 0) {
+        printf("FAIL len=%zu in+%zu out+%zu: byte/word output differs\n", len, in_off, out_off);
+        return 1;
+    }
+
+    // PSRAM 模式每个半缓冲在帧缓冲里就地压缩
+    memcpy(s_inplace_a, s_src, sizeof(s_src));
+    memcpy(s_inplace_b, s_src, sizeof(s_src));
+    ll_cam_yuyv_to_y_bytes((uint8_t *)s_inplace_a + in_off, (uint8_t *)s_inplace_a + in_off, len);
+    ll_cam_yuyv_to_y((uint8_t *)s_inplace_b + in_off, (uint8_t *)s_inplace_b + in_off, len);
+    if (memcmp(s_inplace_a, s_inplace_b, sizeof(s_inplace_a)) != 0) {
+        printf("FAIL len=%zu in+%zu in place: byte/word output differs\n", len, in_off);
+        return 1;
+    }
+    return 0;
+}
+
+typedef size_t (*luma_fn_t)(uint8_t *out, const uint8_t *in, size_t len);
+
+static double bench(luma_fn_t fn, uint8_t *dst, const uint8_t *src)
+{
+    size_t sink = 0;
+    const double t0 = now_ns();
+    for (int i = 0; i < BENCH_ROUNDS; ++i) {
+        sink += fn(dst, src, BENCH_LEN);
+    }
+    const double t1 = now_ns();
+    if (sink == 0) {
+        printf("bench: no output\n");
+    }
+    return (t1 - t0) / ((double)BENCH_ROUNDS * BENCH_LEN);
+}
+
+int main(void)
+{
+    int fails = 0;
+    for (size_t len = 0; len <= 80; ++len) {
+        for (size_t in_off = 0; in_off < 4; ++in_off) {
+            for (size_t out_off = 0; out_off < 4; ++out_off) {
+                fails += check_one(len, in_off, out_off);
+            }
+        }
+    }
+    fails += check_one(MAX_LEN, 0, 0);
+    fails += check_one(MAX_LEN - 8, 0, 0);
+    if (fails) {
+        return 1;
+    }
+    printf("yuyv_luma: word extraction matches byte extraction\n");
+
+    // 主机上只看相对值，防止哪边退化得离谱
+    static uint32_t src[BENCH_LEN / 4], dst[BENCH_LEN / 8];
+    for (size_t i = 0; i < BENCH_LEN / 4; ++i) {
+        src[i] = (rnd() << 16) ^ rnd();
+    }
+    const double nb = bench(ll_cam_yuyv_to_y_bytes, (uint8_t *)dst, (const uint8_t *)src);
+    const double nw = bench(ll_cam_yuyv_to_y, (uint8_t *)dst, (const uint8_t *)src);
+    printf("yuyv_to_y            byte %.3f ns/B  word %.3f ns/B  x%.2f\n", nb, nw, nb / nw);
+    return 0;
+}
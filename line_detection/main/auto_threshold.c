@@ -0,0 +1,102 @@
+#include <string.h>
+#include "auto_threshold.h"
+
+void auto_threshold_init(auto_threshold_t *at, auto_th_mode_t mode, uint8_t initial_th)
+{
+    memset(at, 0, sizeof(*at));
+    at->mode = mode;
+    at->percentile = 10;
+    at->alpha = 0.2f;
+    at->min_th = 20;
+    at->max_th = 200;
+    at->min_contrast = 30;
+    at->th = initial_th;
+}
+
+uint8_t auto_threshold_otsu(const uint32_t hist[256], uint8_t *contrast)
+{
+    uint32_t total = 0;
+    uint64_t sum_all = 0;
+    for (int i = 0; i < 256; ++i) {
+        total += hist[i];
+        sum_all += (uint64_t)i * hist[i];
+    }
+    if (contrast) {
+        *contrast = 0;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // 一遍累加：w0/sum0 为 [0, t) 的像素数和灰度和
+    uint32_t w0 = 0;
+    uint64_t sum0 = 0;
+    float best = -1.0f;
+    int best_t = 0, best_t_hi = 0;
+    float best_m0 = 0, best_m1 = 0;
+    for (int t = 1; t < 256; ++t) {
+        w0 += hist[t - 1];
+        sum0 += (uint64_t)(t - 1) * hist[t - 1];
+        const uint32_t w1 = total - w0;
+        if (w0 == 0) continue;
+        if (w1 == 0) break;
+        const float m0 = (float)sum0 / w0;
+        const float m1 = (float)(sum_all - sum0) / w1;
+        const float d = m1 - m0;
+        // 类间方差 w0 * w1 * (m1 - m0)^2，常数因子不影响 argmax
+        const float between = (float)w0 * (float)w1 * d * d;
+        if (between > best) {
+            best = between;
+            best_t = best_t_hi = t;
+            best_m0 = m0;
+            best_m1 = m1;
+        } else if (between == best) {
+            // 两峰之间的空档方差都一样，取空档中点，边缘模糊像素两边都不偏
+            best_t_hi = t;
+        }
+    }
+    if (contrast) {
+        const float c = best_m1 - best_m0;
+        *contrast = c > 255.0f ? 255 : (uint8_t)c;
+    }
+    return (uint8_t)((best_t + best_t_hi + 1) / 2);
+}
+
+uint8_t auto_threshold_percentile(const uint32_t hist[256], uint8_t pct)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < 256; ++i) {
+        total += hist[i];
+    }
+    const uint32_t target = (uint32_t)(((uint64_t)total * pct + 99) / 100);
+    uint32_t acc = 0;
+    for (int t = 0; t < 256; ++t) {
+        if (acc >= target) {
+            return (uint8_t)t;
+        }
+        acc += hist[t];
+    }
+    return 255;
+}
+
+uint8_t auto_threshold_update(auto_threshold_t *at, const uint32_t hist[256])
+{
+    int raw;
+    if (at->mode == AUTO_TH_PERCENTILE) {
+        raw = auto_threshold_percentile(hist, at->percentile);
+    } else {
+        uint8_t contrast = 0;
+        raw = auto_threshold_otsu(hist, &contrast);
+        // 扫描行里没有线（或全黑）时 Otsu 只会切噪声，保持原阈值
+        if (contrast < at->min_contrast) {
+            raw = -1;
+        }
+    }
+
+    if (raw >= 0) {
+        if (raw < at->min_th) raw = at->min_th;
+        if (raw > at->max_th) raw = at->max_th;
+        at->th += at->alpha * ((float)raw - at->th);
+    }
+    return (uint8_t)(at->th + 0.5f);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 自适应阈值：用本帧扫描行的 256 级直方图算阈值（Otsu 或百分位），
+// 帧间指数平滑后给下一帧用，地面光照变化时不用再手改 TH
+
+typedef enum {
+    AUTO_TH_OTSU,               // 类间方差最大
+    AUTO_TH_PERCENTILE,         // 最暗的 percentile% 像素视为黑线
+} auto_th_mode_t;
+
+typedef struct {
+    auto_th_mode_t mode;
+    uint8_t  percentile;        // PERCENTILE 模式用，1..99
+    float    alpha;             // 平滑系数 (0, 1]，越小越稳，越大跟得越快
+    uint8_t  min_th;            // 输出限幅
+    uint8_t  max_th;
+    uint8_t  min_contrast;      // Otsu 两类均值差小于它（整行同色，没线）时不更新
+    float    th;                // 当前平滑后的阈值
+} auto_threshold_t;
+
+void auto_threshold_init(auto_threshold_t *at, auto_th_mode_t mode, uint8_t initial_th);
+
+/**
+ * @brief 用本帧直方图更新阈值
+ *
+ * @return 下一帧使用的阈值（像素 < 阈值为黑）
+ */
+uint8_t auto_threshold_update(auto_threshold_t *at, const uint32_t hist[256]);
+
+/**
+ * @brief Otsu 阈值，返回 t 使 [0, t) 与 [t, 255] 类间方差最大（并列时取中点）
+ *
+ * @param contrast 可为 NULL，输出两类均值之差
+ */
+uint8_t auto_threshold_otsu(const uint32_t hist[256], uint8_t *contrast);
+
+/**
+ * @brief 百分位阈值，返回最小的 t 使 [0, t) 内像素数 >= total * pct / 100
+ */
+uint8_t auto_threshold_percentile(const uint32_t hist[256], uint8_t pct);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,142 @@
+#include <string.h>
+#include "bin_image.h"
+
+#define BIN_IMAGE_MAX_WORDS ((BIN_IMAGE_MAX_WIDTH + 31) / 32)
+
+bool bin_image_init(bin_image_t *img, uint16_t width, uint16_t height, uint32_t *bits)
+{
+    if (width == 0 || width > BIN_IMAGE_MAX_WIDTH) {
+        return false;
+    }
+    img->width = width;
+    img->height = height;
+    img->words_per_row = (width + 31) / 32;
+    img->bits = bits;
+    memset(bits, 0, bin_image_words(width, height) * sizeof(uint32_t));
+    return true;
+}
+
+// 最后一个字里超出 width 的填充位
+static inline uint32_t pad_mask(const bin_image_t *img)
+{
+    const int used = img->width & 31;
+    return used ? ~((1u << used) - 1) : 0;
+}
+
+// 4 个像素一组做 SWAR 比较：偶数 / 奇数字节各摊到 16 位通道里，通道第 8 位放一个保护位，
+// 减去阈值后保护位还在就说明 像素 >= th；返回 4 位结果，bit i 对应第 i 个像素（小端）
+static inline uint32_t lt4(uint32_t x, uint32_t th16)
+{
+    const uint32_t e = ~(((x & 0x00FF00FF) | 0x01000100) - th16) & 0x01000100;
+    const uint32_t o = ~((((x >> 8) & 0x00FF00FF) | 0x01000100) - th16) & 0x01000100;
+    const uint32_t lo = e | (o << 1);           // 第 8、9、24、25 位 = 像素 0、1、2、3
+    return ((lo >> 8) | (lo >> 22)) & 0xF;
+}
+
+void bin_image_threshold(bin_image_t *dst, const uint8_t *gray, size_t stride, uint8_t th)
+{
+    if (!stride) {
+        stride = dst->width;
+    }
+    const int full = dst->width >> 5;
+    const int rest = dst->width & 31;
+    const uint32_t th16 = th * 0x00010001u;
+    for (int y = 0; y < dst->height; ++y) {
+        const uint8_t *p = gray + (size_t)y * stride;
+        uint32_t *o = dst->bits + (size_t)y * dst->words_per_row;
+        for (int i = 0; i < full; ++i, p += 32) {
+            // 每次读 4 字节而不是逐字节读，读内存次数少 4 倍
+            uint32_t w = 0;
+            for (int k = 0; k < 8; ++k) {
+                uint32_t x;
+                memcpy(&x, p + 4 * k, 4);
+                w |= lt4(x, th16) << (4 * k);
+            }
+            o[i] = w;
+        }
+        if (rest) {
+            uint32_t w = 0;
+            for (int b = 0; b < rest; ++b) {
+                w |= (uint32_t)(p[b] < th) << b;
+            }
+            o[full] = w;
+        }
+    }
+}
+
+// 3x3 方形结构元可分离：先行内左右 1 像素，再上下 1 行
+// 行内：左邻居是 (cur << 1) 再补上前一个字的最高位，右邻居是 (cur >> 1) 再补上后一个字的最低位
+// 逐字从左往右做，前一个字的原值留在寄存器里，所以 dst == src 也成立
+static void morph(bin_image_t *dst, const bin_image_t *src, bool erode)
+{
+    const int n = src->words_per_row;
+    const uint32_t fill = erode ? ~0u : 0;
+    const uint32_t pad = erode ? pad_mask(src) : 0;
+
+    for (int y = 0; y < src->height; ++y) {
+        const uint32_t *s = src->bits + (size_t)y * n;
+        uint32_t *d = dst->bits + (size_t)y * n;
+        uint32_t prev = fill;
+        uint32_t cur = s[0] | (n == 1 ? pad : 0);
+        for (int i = 0; i < n; ++i) {
+            uint32_t next = fill;
+            if (i + 1 < n) {
+                next = s[i + 1] | (i + 2 == n ? pad : 0);
+            }
+            const uint32_t left = (cur << 1) | (prev >> 31);
+            const uint32_t right = (cur >> 1) | (next << 31);
+            d[i] = erode ? (cur & left & right) : (cur | left | right);
+            prev = cur;
+            cur = next;
+        }
+    }
+
+    // 纵向：就地处理，上一行的横向结果先存起来，下一行还没被改写；按位独立，填充位最后清掉
+    uint32_t above[BIN_IMAGE_MAX_WORDS];
+    for (int i = 0; i < n; ++i) {
+        above[i] = fill;
+    }
+    for (int y = 0; y < dst->height; ++y) {
+        uint32_t *d = dst->bits + (size_t)y * n;
+        const uint32_t *below = (y + 1 < dst->height) ? d + n : NULL;
+        for (int i = 0; i < n; ++i) {
+            const uint32_t c = d[i];
+            const uint32_t b = below ? below[i] : fill;
+            d[i] = erode ? (above[i] & c & b) : (above[i] | c | b);
+            above[i] = c;
+        }
+        d[n - 1] &= ~pad_mask(dst);
+    }
+}
+
+void bin_image_erode(bin_image_t *dst, const bin_image_t *src)
+{
+    morph(dst, src, true);
+}
+
+void bin_image_dilate(bin_image_t *dst, const bin_image_t *src)
+{
+    morph(dst, src, false);
+}
+
+void bin_image_open(bin_image_t *dst, const bin_image_t *src)
+{
+    morph(dst, src, true);
+    morph(dst, dst, false);
+}
+
+void bin_image_close(bin_image_t *dst, const bin_image_t *src)
+{
+    morph(dst, src, false);
+    morph(dst, dst, true);
+}
+
+int bin_image_row_count(const bin_image_t *img, int y)
+{
+    const uint32_t *r = img->bits + (size_t)y * img->words_per_row;
+    int n = 0;
+    for (int i = 0; i < img->words_per_row; ++i) {
+        n += __builtin_popcount(r[i]);
+    }
+    return n;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 1bpp 打包二值图：阈值化之后每像素只要 1 位，形态学用 32 位字的移位和与或运算，
+// 一次处理 32 个像素；160x64 的 ROI 只占 1.25KB，整幅放在内部 SRAM
+//
+// 像素 x 在第 x/32 个字的第 x%32 位（LSB 是最左边），1 表示黑线（前景）
+// 每行末尾不足 32 位的填充位始终为 0
+
+#define BIN_IMAGE_MAX_WIDTH 640
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint16_t words_per_row;     // (width + 31) / 32
+    uint32_t *bits;             // height * words_per_row 个字，由调用者提供
+} bin_image_t;
+
+/**
+ * @brief 存放 width x height 二值图需要的 32 位字数
+ */
+static inline size_t bin_image_words(uint16_t width, uint16_t height)
+{
+    return (size_t)((width + 31) / 32) * height;
+}
+
+/**
+ * @brief 绑定存储并清零
+ *
+ * @param bits 至少 bin_image_words(width, height) 个字
+ *
+ * @return width 超过 BIN_IMAGE_MAX_WIDTH 时返回 false
+ */
+bool bin_image_init(bin_image_t *img, uint16_t width, uint16_t height, uint32_t *bits);
+
+static inline bool bin_image_get(const bin_image_t *img, int x, int y)
+{
+    return (img->bits[(size_t)y * img->words_per_row + (x >> 5)] >> (x & 31)) & 1;
+}
+
+/**
+ * @brief 阈值化并打包：一遍读灰度，直接写出位图，中间不落 8bit 掩码
+ *
+ * @param gray   8bit 灰度，尺寸与 dst 相同
+ * @param stride 灰度行跨度（字节），0 表示等于 width
+ * @param th     像素 < th 置 1
+ */
+void bin_image_threshold(bin_image_t *dst, const uint8_t *gray, size_t stride, uint8_t th);
+
+/**
+ * @brief 3x3 方形结构元腐蚀 / 膨胀，dst 可以和 src 是同一幅图
+ *
+ * 图像外按“不影响结果”处理：腐蚀时视为 1，膨胀时视为 0，边缘不会被额外削掉或长出
+ */
+void bin_image_erode(bin_image_t *dst, const bin_image_t *src);
+void bin_image_dilate(bin_image_t *dst, const bin_image_t *src);
+
+/**
+ * @brief 开运算（先腐蚀后膨胀，去孤立噪点）/ 闭运算（先膨胀后腐蚀，补线上小洞）
+ */
+void bin_image_open(bin_image_t *dst, const bin_image_t *src);
+void bin_image_close(bin_image_t *dst, const bin_image_t *src);
+
+/**
+ * @brief 一行里前景像素个数
+ */
+int bin_image_row_count(const bin_image_t *img, int y);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,126 @@
+#include <stddef.h>
+#include "frame_ring.h"
+
+bool frame_ring_init(frame_ring_t *ring, uint32_t capacity, frame_ring_policy_t policy,
+                     frame_ring_release_cb_t release, void *release_arg)
+{
+    if (capacity == 0 || capacity > FRAME_RING_MAX_CAP || (capacity & (capacity - 1)) != 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < FRAME_RING_MAX_CAP; ++i) {
+        atomic_init(&ring->slot[i], NULL);
+    }
+    ring->mask = capacity - 1;
+    ring->policy = policy;
+    ring->release = release;
+    ring->release_arg = release_arg;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->pushed, 0);
+    atomic_init(&ring->popped, 0);
+    atomic_init(&ring->dropped_full, 0);
+    atomic_init(&ring->dropped_stale, 0);
+    return true;
+}
+
+static inline void ring_release(frame_ring_t *ring, void *item)
+{
+    if (ring->release && item) {
+        ring->release(item, ring->release_arg);
+    }
+}
+
+static inline void *slot_get(frame_ring_t *ring, uint32_t pos)
+{
+    return atomic_load_explicit(&ring->slot[pos & ring->mask], memory_order_relaxed);
+}
+
+/*
+ * 认领 tail 处的一帧。LATEST 模式下生产者在队列满时也会推进 tail，所以两边都用 CAS：
+ * 谁把 tail 从 *tail 推到 *tail + 1 谁就拿到这一帧。失败时 *tail 更新为当前值
+ */
+static inline bool claim_tail(frame_ring_t *ring, uint32_t *tail, void **item)
+{
+    void *it = slot_get(ring, *tail);
+    if (!atomic_compare_exchange_strong_explicit(&ring->tail, tail, *tail + 1,
+                                                 memory_order_acq_rel, memory_order_acquire)) {
+        return false;
+    }
+    *item = it;
+    (*tail)++;
+    return true;
+}
+
+bool frame_ring_push(frame_ring_t *ring, void *item)
+{
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail > ring->mask) {
+        if (ring->policy != FRAME_RING_LATEST) {
+            // 满：丢掉手上这一帧
+            atomic_fetch_add_explicit(&ring->dropped_full, 1, memory_order_relaxed);
+            ring_release(ring, item);
+            return false;
+        }
+        // 满：最新的帧不能丢，从消费者手里收回最旧的一帧；
+        // CAS 失败说明消费者刚取走一帧，空位已经有了
+        void *old;
+        if (claim_tail(ring, &tail, &old)) {
+            ring_release(ring, old);
+            atomic_fetch_add_explicit(&ring->dropped_stale, 1, memory_order_relaxed);
+        }
+    }
+    atomic_store_explicit(&ring->slot[head & ring->mask], item, memory_order_relaxed);
+    // release：保证消费者看到 head 前先看到 slot
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    atomic_fetch_add_explicit(&ring->pushed, 1, memory_order_relaxed);
+    return true;
+}
+
+void *frame_ring_pop(frame_ring_t *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    while (true) {
+        const uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (head == tail) {
+            return NULL;
+        }
+        void *item;
+        if (!claim_tail(ring, &tail, &item)) {
+            continue;
+        }
+        // LATEST：旧帧全部归还，只留最新一帧
+        if (ring->policy == FRAME_RING_LATEST && head - tail > 0) {
+            ring_release(ring, item);
+            atomic_fetch_add_explicit(&ring->dropped_stale, 1, memory_order_relaxed);
+            continue;
+        }
+        atomic_fetch_add_explicit(&ring->popped, 1, memory_order_relaxed);
+        return item;
+    }
+}
+
+void frame_ring_drain(frame_ring_t *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    void *item;
+    while (tail != atomic_load_explicit(&ring->head, memory_order_acquire)) {
+        if (claim_tail(ring, &tail, &item)) {
+            ring_release(ring, item);
+        }
+    }
+}
+
+uint32_t frame_ring_count(frame_ring_t *ring)
+{
+    return atomic_load_explicit(&ring->head, memory_order_acquire) -
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+void frame_ring_get_stats(frame_ring_t *ring, frame_ring_stats_t *out)
+{
+    out->pushed = atomic_load_explicit(&ring->pushed, memory_order_relaxed);
+    out->popped = atomic_load_explicit(&ring->popped, memory_order_relaxed);
+    out->dropped_full = atomic_load_explicit(&ring->dropped_full, memory_order_relaxed);
+    out->dropped_stale = atomic_load_explicit(&ring->dropped_stale, memory_order_relaxed);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 单生产者/单消费者无锁环形队列，用来在采集任务和视觉任务之间传 camera_fb_t*
+// 生产者只写 head，tail 由消费者推进；LATEST 模式下队列满时生产者也用 CAS 推进 tail，
+// 收回最旧的一帧，所以新帧永远不会被丢，仍然不需要锁
+// 元素用 void*，这样不依赖 esp_camera.h，主机上也能编译
+
+#define FRAME_RING_MAX_CAP 8     // 必须是 2 的幂
+
+typedef enum {
+    FRAME_RING_DROP_NEWEST,      // 满了就丢新来的帧，消费者按顺序取
+    FRAME_RING_LATEST,           // 消费者每次只拿最新的一帧，旧帧直接释放；满了顶掉最旧的帧
+} frame_ring_policy_t;
+
+// 被丢弃的帧通过该回调归还（例如 esp_camera_fb_return）
+typedef void (*frame_ring_release_cb_t)(void *item, void *arg);
+
+typedef struct {
+    uint32_t pushed;             // 成功入队
+    uint32_t popped;             // 交给消费者
+    uint32_t dropped_full;       // 入队时队列已满被丢弃（只有 DROP_NEWEST）
+    uint32_t dropped_stale;      // LATEST 模式下被更新的帧顶掉（出队时，或入队时队列已满）
+} frame_ring_stats_t;
+
+typedef struct {
+    _Atomic(void *) slot[FRAME_RING_MAX_CAP];
+    uint32_t mask;
+    frame_ring_policy_t policy;
+    frame_ring_release_cb_t release;
+    void *release_arg;
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    _Atomic uint32_t pushed;
+    _Atomic uint32_t popped;
+    _Atomic uint32_t dropped_full;
+    _Atomic uint32_t dropped_stale;
+} frame_ring_t;
+
+/**
+ * @brief 初始化队列
+ *
+ * @param capacity 容量，2 的幂且不超过 FRAME_RING_MAX_CAP
+ *
+ * @return 参数非法时返回 false
+ */
+bool frame_ring_init(frame_ring_t *ring, uint32_t capacity, frame_ring_policy_t policy,
+                     frame_ring_release_cb_t release, void *release_arg);
+
+/**
+ * @brief 生产者入队
+ *
+ * 队列满时：DROP_NEWEST 调用 release 归还 item 并计入 dropped_full；
+ * LATEST 归还队列里最旧的一帧并计入 dropped_stale，item 照常入队
+ *
+ * @return 入队成功返回 true（LATEST 模式总是 true）
+ */
+bool frame_ring_push(frame_ring_t *ring, void *item);
+
+/**
+ * @brief 消费者出队，队列空时返回 NULL
+ *
+ * LATEST 模式下会释放除最新一帧外的所有帧
+ */
+void *frame_ring_pop(frame_ring_t *ring);
+
+/**
+ * @brief 消费者退出时归还队列中剩余的所有帧
+ */
+void frame_ring_drain(frame_ring_t *ring);
+
+uint32_t frame_ring_count(frame_ring_t *ring);
+
+void frame_ring_get_stats(frame_ring_t *ring, frame_ring_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,83 @@
+#include <string.h>
+#include <stdlib.h>
+#include "latency_trace.h"
+
+typedef struct {
+    uint32_t sample[LATENCY_TRACE_WINDOW];
+    uint32_t next;                  // 下一个写入位置
+    uint32_t count;
+} lat_ring_t;
+
+static lat_ring_t s_ring[LAT_STAGE_MAX];
+
+static const char *const s_stage_name[LAT_STAGE_MAX] = {
+    [LAT_STAGE_VSYNC_TO_EOF]        = "vsync->eof",
+    [LAT_STAGE_EOF_TO_TAKE]         = "eof->take",
+    [LAT_STAGE_TAKE_TO_ANALYZED]    = "take->analyzed",
+    [LAT_STAGE_ANALYZED_TO_CONTROL] = "analyzed->control",
+    [LAT_STAGE_TOTAL]               = "vsync->control",
+};
+
+void latency_trace_reset(void)
+{
+    memset(s_ring, 0, sizeof(s_ring));
+}
+
+static void ring_add(lat_stage_t stage, int64_t from, int64_t to)
+{
+    if (from <= 0 || to <= 0 || to < from) {
+        return;
+    }
+    lat_ring_t *r = &s_ring[stage];
+    int64_t d = to - from;
+    r->sample[r->next] = d > UINT32_MAX ? UINT32_MAX : (uint32_t)d;
+    r->next = (r->next + 1) % LATENCY_TRACE_WINDOW;
+    if (r->count < LATENCY_TRACE_WINDOW) {
+        r->count++;
+    }
+}
+
+void latency_trace_record(const lat_stamps_t *st)
+{
+    ring_add(LAT_STAGE_VSYNC_TO_EOF, st->vsync_us, st->eof_us);
+    // PSRAM 非 JPEG 模式没有 EOF，EOF->take 就没法分，直接跳过
+    ring_add(LAT_STAGE_EOF_TO_TAKE, st->eof_us, st->take_us);
+    ring_add(LAT_STAGE_TAKE_TO_ANALYZED, st->take_us, st->analyzed_us);
+    ring_add(LAT_STAGE_ANALYZED_TO_CONTROL, st->analyzed_us, st->control_us);
+    ring_add(LAT_STAGE_TOTAL, st->vsync_us, st->control_us);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+void latency_trace_stats(lat_stage_t stage, lat_stage_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    const lat_ring_t *r = &s_ring[stage];
+    if (r->count == 0) {
+        return;
+    }
+
+    // 排序副本求分位数，128 个样本开销可以忽略（只在每秒报告时调用）
+    uint32_t sorted[LATENCY_TRACE_WINDOW];
+    uint64_t sum = 0;
+    memcpy(sorted, r->sample, r->count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < r->count; ++i) {
+        sum += sorted[i];
+    }
+    qsort(sorted, r->count, sizeof(uint32_t), cmp_u32);
+
+    out->count = r->count;
+    out->min_us = sorted[0];
+    out->max_us = sorted[r->count - 1];
+    out->avg_us = (uint32_t)(sum / r->count);
+    out->p99_us = sorted[(r->count * 99 + 99) / 100 - 1];
+}
+
+const char *latency_trace_stage_name(lat_stage_t stage)
+{
+    return stage < LAT_STAGE_MAX ? s_stage_name[stage] : "?";
+}
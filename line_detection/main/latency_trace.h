@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 分阶段延迟统计：VSYNC -> DMA EOF -> cam_take -> 分析完成 -> 控制输出
+// 每个阶段保留最近 LATENCY_TRACE_WINDOW 个样本（定长环形），报告时算 min/avg/p99/max
+// 只在一个任务里调用 record/report，不加锁
+
+#define LATENCY_TRACE_WINDOW 128
+
+typedef enum {
+    LAT_STAGE_VSYNC_TO_EOF,         // 传感器读出 + DMA
+    LAT_STAGE_EOF_TO_TAKE,          // cam_task 拷贝 + 驱动队列等待
+    LAT_STAGE_TAKE_TO_ANALYZED,     // frame_ring 交接 + 分析
+    LAT_STAGE_ANALYZED_TO_CONTROL,  // 控制计算
+    LAT_STAGE_TOTAL,                // VSYNC -> 控制输出
+    LAT_STAGE_MAX,
+} lat_stage_t;
+
+// 各时间点，单位 us（esp_timer_get_time），0 表示没有该时间点
+typedef struct {
+    int64_t vsync_us;
+    int64_t eof_us;
+    int64_t take_us;
+    int64_t analyzed_us;
+    int64_t control_us;
+} lat_stamps_t;
+
+typedef struct {
+    uint32_t count;                 // 窗口内样本数
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} lat_stage_stats_t;
+
+void latency_trace_reset(void);
+
+/**
+ * @brief 记录一帧的时间点，缺失的时间点对应阶段不计入
+ */
+void latency_trace_record(const lat_stamps_t *st);
+
+/**
+ * @brief 计算某阶段当前窗口的统计
+ */
+void latency_trace_stats(lat_stage_t stage, lat_stage_stats_t *out);
+
+const char *latency_trace_stage_name(lat_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,6 +13,16 @@
 #include "esp_event.h"
 #include "esp_wifi.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "line_track.h"
+#include "line_predict.h"
+#include "auto_threshold.h"
+#include "frame_ring.h"
+#include "latency_trace.h"
+#include "stream_server.h"
+
 static const char *TAG = "cam";
 static httpd_handle_t s_server = NULL;
 
@@ -60,37 +70,73 @@ static httpd_handle_t s_server = NULL;
 #define CAM_PIN_PCLK 13
 #endif
 
-static esp_err_t camera_init(void)
+// ROI：只采集底部这条带（frame_size 坐标），传感器和 DMA 都只出这些行；0 表示整帧
+// OV2640 要求 4 的倍数，取 8 的倍数各传感器和 DMA 分块都没问题
+#define CAM_ROI_Y       56
+#define CAM_ROI_HEIGHT  64
+
+// 帧缓冲放在内部 SRAM 的静态区：不走 PSRAM，切 ROI / 分辨率也不会把堆切碎
+// 按整帧 QQVGA 灰度分配，ROI 不可用退回整帧时也装得下
+// 最坏情况下 frame_ring 排满 FRAME_RING_DEPTH 块，视觉任务和图传各拿一块，
+// 再留一块给 DMA，cam_task 才不会因为没有空 fb 丢帧（drop_no_fb）
+#define FRAME_RING_DEPTH    1       // LATEST 只留最新一帧，多一格只会多押一块 fb
+#define CAM_FB_COUNT        (FRAME_RING_DEPTH + 3)
+#define CAM_FB_POOL_BYTES   (160 * 120)
+
+static uint8_t s_fb_arena[CAM_FB_COUNT][CAM_FB_POOL_BYTES] __attribute__((aligned(16)));
+static uint8_t *s_fb_pool[CAM_FB_COUNT];
+
+static camera_config_t s_cam_config = {
+    .pin_pwdn = CAM_PIN_PWDN,
+    .pin_reset = CAM_PIN_RESET,
+    .pin_xclk = CAM_PIN_XCLK,
+    .pin_sccb_sda = CAM_PIN_SIOD,
+    .pin_sccb_scl = CAM_PIN_SIOC,
+    .pin_d7 = CAM_PIN_D9,
+    .pin_d6 = CAM_PIN_D8,
+    .pin_d5 = CAM_PIN_D7,
+    .pin_d4 = CAM_PIN_D6,
+    .pin_d3 = CAM_PIN_D5,
+    .pin_d2 = CAM_PIN_D4,
+    .pin_d1 = CAM_PIN_D3,
+    .pin_d0 = CAM_PIN_D2,
+    .pin_vsync = CAM_PIN_VSYNC,
+    .pin_href = CAM_PIN_HREF,
+    .pin_pclk = CAM_PIN_PCLK,
+    .xclk_freq_hz   = 20000000,             // 20MHz 常用；若不亮可试 10MHz/16MHz
+    .ledc_timer     = LEDC_TIMER_0,
+    .ledc_channel   = LEDC_CHANNEL_0,
+    // **关键：巡线建议灰度格式，避免 JPEG 解码开销**
+    .pixel_format   = PIXFORMAT_GRAYSCALE,  // 或 PIXFORMAT_YUV422 / RGB565 / JPEG
+    .frame_size     = FRAMESIZE_QQVGA,      // 160x120；也可 QVGA(320x240)
+    .jpeg_quality   = 12,                   // 仅 JPEG 有效
+    .fb_count       = CAM_FB_COUNT,
+    .grab_mode      = CAMERA_GRAB_LATEST,
+    .roi_y          = CAM_ROI_Y,
+    .roi_height     = CAM_ROI_HEIGHT,
+    .fb_pool        = s_fb_pool,            // camera_init_start 里指向 s_fb_arena
+    .fb_pool_size   = CAM_FB_POOL_BYTES,
+};
+
+// 相机在自己的任务里初始化（传感器寄存器和 DMA/帧缓冲分配也互相重叠），这段时间去起 Wi-Fi
+static esp_err_t camera_init_start(void)
+{
+    for (int i = 0; i < CAM_FB_COUNT; ++i) {
+        s_fb_pool[i] = s_fb_arena[i];
+    }
+    return esp_camera_init_async(&s_cam_config, NULL, NULL);
+}
+
+static esp_err_t camera_init_finish(void)
 {
-    camera_config_t config = {
-        .pin_pwdn = CAM_PIN_PWDN,
-        .pin_reset = CAM_PIN_RESET,
-        .pin_xclk = CAM_PIN_XCLK,
-        .pin_sccb_sda = CAM_PIN_SIOD,
-        .pin_sccb_scl = CAM_PIN_SIOC,
-        .pin_d7 = CAM_PIN_D9,
-        .pin_d6 = CAM_PIN_D8,
-        .pin_d5 = CAM_PIN_D7,
-        .pin_d4 = CAM_PIN_D6,
-        .pin_d3 = CAM_PIN_D5,
-        .pin_d2 = CAM_PIN_D4,
-        .pin_d1 = CAM_PIN_D3,
-        .pin_d0 = CAM_PIN_D2,
-        .pin_vsync = CAM_PIN_VSYNC,
-        .pin_href = CAM_PIN_HREF,
-        .pin_pclk = CAM_PIN_PCLK,
-        .xclk_freq_hz   = 20000000,             // 20MHz 常用；若不亮可试 10MHz/16MHz
-        .ledc_timer     = LEDC_TIMER_0,
-        .ledc_channel   = LEDC_CHANNEL_0,
-        // **关键：巡线建议灰度格式，避免 JPEG 解码开销**
-        .pixel_format   = PIXFORMAT_GRAYSCALE,  // 或 PIXFORMAT_YUV422 / RGB565 / JPEG
-        .frame_size     = FRAMESIZE_QQVGA,      // 160x120；也可 QVGA(320x240)
-        .jpeg_quality   = 12,                   // 仅 JPEG 有效
-        .fb_count       = 1,                    // 单缓冲更省内存
-        .grab_mode      = CAMERA_GRAB_WHEN_EMPTY,
-    };
-
-    esp_err_t err = esp_camera_init(&config);
+    esp_err_t err = esp_camera_init_wait(ESP_CAMERA_WAIT_FOREVER);
+    if (err == ESP_ERR_CAMERA_NOT_SUPPORTED && s_cam_config.roi_height) {
+        // 传感器没有 set_roi，退回整帧
+        ESP_LOGW(TAG, "ROI not supported by sensor, capturing full frame");
+        s_cam_config.roi_y = 0;
+        s_cam_config.roi_height = 0;
+        err = esp_camera_init(&s_cam_config);
+    }
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "esp_camera_init failed: %s", esp_err_to_name(err));
         return err;
@@ -109,56 +155,259 @@ static esp_err_t camera_init(void)
     return ESP_OK;
 }
 
+static line_track_config_t s_track_cfg;
+static line_track_result_t s_track_res;
+static uint32_t s_hist[256];
+static auto_threshold_t s_auto_th;
+static line_predict_t s_predict;
+static uint32_t s_pixels;               // 本统计周期内累计读过的像素
+
 static void analyze_frame_gray(const camera_fb_t* fb)
 {
-    // 简单示例：统计低于某阈值(黑)的像素比例，便于你确认黑白分布
-    const uint8_t* p = fb->buf;
-    const int total = fb->len; // 灰度模式下 1 字节/像素
-    int black = 0;
-    const uint8_t TH = 90;     // 简单阈值
-    for (int i = 0; i < total; ++i) black += (p[i] < TH);
-    float ratio = (float)black * 100.0f / (float)total;
-    ESP_LOGI(TAG, "Gray stat: black<th(%d) = %.2f%%", TH, ratio);
+    // 分辨率变化（或第一帧）时按实际宽高重建扫描行
+    if (s_track_cfg.width != fb->width || s_track_cfg.height != fb->height) {
+        line_track_default_config(&s_track_cfg, fb->width, fb->height, 8);
+        if (CAM_ROI_HEIGHT && fb->height == CAM_ROI_HEIGHT) {
+            // ROI 本身就是底部带，扫描行铺满整条带
+            for (int i = 0; i < s_track_cfg.row_count; ++i) {
+                s_track_cfg.rows[i] = (uint16_t)((fb->height - 1) * i / (s_track_cfg.row_count - 1));
+            }
+        }
+        s_track_cfg.hist = s_hist;
+        auto_threshold_init(&s_auto_th, AUTO_TH_OTSU, s_track_cfg.threshold);
+        line_predict_init(&s_predict, &s_track_cfg);
+        ESP_LOGI(TAG, "line_track: %dx%d, %d rows, th=%d", fb->width, fb->height,
+                 s_track_cfg.row_count, s_track_cfg.threshold);
+    }
+    // 本帧用上一帧算出的阈值；扫描时顺带出直方图，给下一帧更新阈值
+    // 稳定跟踪时只扫预测位置附近的窗口
+    line_predict_process(&s_predict, &s_track_cfg, fb->buf, &s_track_res);
+    s_pixels += s_track_res.pixels;
+    s_track_cfg.threshold = auto_threshold_update(&s_auto_th, s_hist);
 }
 
-void app_main(void)
+// ===== Wi-Fi（仅用于调试图传） =====
+static void wifi_event_handler(void* arg, esp_event_base_t base, int32_t id, void* data)
 {
-    ESP_ERROR_CHECK(camera_init());
-    // 先抓一帧再打印宽高和像素格式（不同 esp32-camera 版本不再提供 status.framesize_width/height）
-    camera_fb_t* fb0 = esp_camera_fb_get();
-    if (fb0) {
-        ESP_LOGI(TAG, "Camera started. FrameSize=%dx%d, fmt=%d", fb0->width, fb0->height, (int)fb0->format);
-        esp_camera_fb_return(fb0);
-    } else {
-        ESP_LOGW(TAG, "Camera started but first frame is NULL");
+    if (base == WIFI_EVENT && id == WIFI_EVENT_STA_START) {
+        esp_wifi_connect();
+    } else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+        ESP_LOGW(TAG, "Wi-Fi disconnected, retrying");
+        esp_wifi_connect();
+    } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t* ev = (ip_event_got_ip_t*)data;
+        ESP_LOGI(TAG, "stream at http://" IPSTR "/stream", IP2STR(&ev->ip_info.ip));
     }
+}
 
-    int64_t t0 = esp_timer_get_time();
-    int frames = 0;
+// 相机驱动把上次探测到的传感器记在 NVS 里，要在 camera_init_start 之前初始化
+static void nvs_init(void)
+{
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(err);
+}
+
+static esp_err_t wifi_init_sta(void)
+{
+    if (strlen(CONFIG_LINE_WIFI_SSID) == 0) {
+        ESP_LOGI(TAG, "LINE_WIFI_SSID not set, streaming disabled");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, wifi_event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_event_handler, NULL));
+
+    wifi_config_t wifi_config = { 0 };
+    strlcpy((char*)wifi_config.sta.ssid, CONFIG_LINE_WIFI_SSID, sizeof(wifi_config.sta.ssid));
+    strlcpy((char*)wifi_config.sta.password, CONFIG_LINE_WIFI_PASSWORD, sizeof(wifi_config.sta.password));
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    // 省电模式会让图传卡顿
+    ESP_ERROR_CHECK(esp_wifi_start());
+    esp_wifi_set_ps(WIFI_PS_NONE);
+    return ESP_OK;
+}
+
+// ===== 控制阶段（占位）=====
+// 简单 PD 式转向量：偏移 + 航向，范围 [-1, 1]；丢线时保持上一次输出。
+// 本工程不接电机 / 舵机，转向量只进每秒的日志；延迟统计里 analyzed -> control 量的就是这一步
+#define STEER_K_OFFSET  0.8f
+#define STEER_K_HEADING 0.5f
+
+static float s_steer = 0.0f;
+
+static void control_stage(const line_track_result_t* res)
+{
+    if (res->valid) {
+        float u = STEER_K_OFFSET * res->offset + STEER_K_HEADING * res->heading;
+        if (u > 1.0f) u = 1.0f;
+        if (u < -1.0f) u = -1.0f;
+        s_steer = u;
+    }
+}
+
+static void log_latency(void)
+{
+    for (int i = 0; i < LAT_STAGE_MAX; ++i) {
+        lat_stage_stats_t st;
+        latency_trace_stats((lat_stage_t)i, &st);
+        if (st.count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "lat %-17s min=%5u avg=%5u p99=%5u max=%5u us (n=%u)", latency_trace_stage_name((lat_stage_t)i),
+                 (unsigned)st.min_us, (unsigned)st.avg_us, (unsigned)st.p99_us, (unsigned)st.max_us, (unsigned)st.count);
+    }
+}
+
+// ===== 双核流水线：采集任务 -> frame_ring -> 视觉任务 =====
+#define CAPTURE_CORE        0       // cam_task 默认也在核 0（CONFIG_CAMERA_CORE0）
+#define VISION_CORE         1
+
+static frame_ring_t s_ring;
+static TaskHandle_t s_vision_task = NULL;
+static uint16_t s_exposure;             // 最近一帧的曝光 / 增益快照
+static uint8_t s_gain;
 
+static void ring_release_fb(void *item, void *arg)
+{
+    esp_camera_fb_return((camera_fb_t *)item);
+}
+
+static void capture_task(void *arg)
+{
     while (1) {
         camera_fb_t* fb = esp_camera_fb_get();
         if (!fb) {
             ESP_LOGW(TAG, "fb NULL");
             continue;
         }
-
-        // 做点最小处理（仅灰度模式下示例）
-        if (fb->format == PIXFORMAT_GRAYSCALE) {
-            analyze_frame_gray(fb);
+        // 队列满时 frame_ring_push 归还最旧的那一帧，新帧照常入队
+        if (frame_ring_push(&s_ring, fb)) {
+            xTaskNotifyGive(s_vision_task);
         }
+    }
+}
+
+static void vision_task(void *arg)
+{
+    int64_t t0 = esp_timer_get_time();
+    int frames = 0;
+    frame_ring_stats_t last = {0};
+    camera_stats_t cam_last = {0};
+    uint32_t last_seq = 0, seq_lost = 0;
 
-        esp_camera_fb_return(fb);
-        frames++;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+
+        camera_fb_t* fb;
+        // 最新帧优先：pop 会把积压的旧帧归还给驱动
+        while ((fb = (camera_fb_t *)frame_ring_pop(&s_ring)) != NULL) {
+            // seq 每个 VSYNC 加一，跳号就是这中间的帧丢了（驱动里或 frame_ring 里）
+            if (last_seq && fb->seq > last_seq + 1) {
+                seq_lost += fb->seq - last_seq - 1;
+            }
+            last_seq = fb->seq;
+            lat_stamps_t st = {0};
+            camera_fb_timing_t tm;
+            if (esp_camera_fb_get_timing(fb, &tm) == ESP_OK) {
+                st.vsync_us = tm.vsync_us;
+                st.eof_us = tm.eof_us;
+                st.take_us = tm.take_us;
+            }
+            s_exposure = fb->exposure;
+            s_gain = fb->gain;
+            if (fb->format == PIXFORMAT_GRAYSCALE) {
+                analyze_frame_gray(fb);
+            }
+            st.analyzed_us = esp_timer_get_time();
+            control_stage(&s_track_res);
+            st.control_us = esp_timer_get_time();
+            // 有图传客户端在等就把 fb 交给 httpd 任务编码，否则直接归还
+            if (!stream_server_offer(fb)) {
+                esp_camera_fb_return(fb);
+            }
+            latency_trace_record(&st);
+            frames++;
+        }
 
         int64_t now = esp_timer_get_time();
         if (now - t0 >= 1000000) {
-            ESP_LOGI(TAG, "FPS=%d", frames);
+            frame_ring_stats_t st;
+            frame_ring_get_stats(&s_ring, &st);
+            ESP_LOGI(TAG, "FPS=%d captured=%u drop_full=%u drop_stale=%u", frames,
+                     (unsigned)(st.pushed + st.dropped_full - last.pushed - last.dropped_full),
+                     (unsigned)(st.dropped_full - last.dropped_full),
+                     (unsigned)(st.dropped_stale - last.dropped_stale));
+            if (s_track_res.valid) {
+                ESP_LOGI(TAG, "line: offset=%.3f heading=%.1fdeg rows=%d steer=%.2f th=%d",
+                         s_track_res.offset, s_track_res.heading * 57.2958f, s_track_res.rows_found, s_steer,
+                         s_track_cfg.threshold);
+            } else {
+                ESP_LOGI(TAG, "line: lost (rows=%d th=%d)", s_track_res.rows_found, s_track_cfg.threshold);
+            }
+            ESP_LOGI(TAG, "scan: %u px/frame, window half=%u, rescans=%u",
+                     (unsigned)(frames ? s_pixels / frames : 0), s_predict.half, (unsigned)s_predict.rescans);
+            s_pixels = 0;
+            camera_stats_t cs;
+            if (esp_camera_get_stats(&cs) == ESP_OK) {
+                const uint32_t taken = cs.frames_taken - cam_last.frames_taken;
+                ESP_LOGI(TAG, "cam: vsync=%u lost=%u no_fb=%u ovf=%u size=%u q_full=%u ev_ovf=%u "
+                         "qwait avg=%u max=%u us exp=%u gain=%u",
+                         (unsigned)(cs.vsyncs - cam_last.vsyncs), (unsigned)seq_lost,
+                         (unsigned)(cs.drop_no_fb - cam_last.drop_no_fb),
+                         (unsigned)(cs.drop_fb_overflow + cs.drop_dma_overflow
+                                    - cam_last.drop_fb_overflow - cam_last.drop_dma_overflow),
+                         (unsigned)(cs.drop_size - cam_last.drop_size),
+                         (unsigned)(cs.drop_queue_full - cam_last.drop_queue_full),
+                         (unsigned)(cs.event_overflow - cam_last.event_overflow),
+                         (unsigned)(taken ? (cs.queue_wait_sum_us - cam_last.queue_wait_sum_us) / taken : 0),
+                         (unsigned)cs.queue_wait_max_us, (unsigned)s_exposure, (unsigned)s_gain);
+                cam_last = cs;
+            }
+            seq_lost = 0;
+            log_latency();
+            last = st;
             frames = 0;
             t0 = now;
         }
+    }
+}
+
+void app_main(void)
+{
+    nvs_init();
+    ESP_ERROR_CHECK(camera_init_start());
+    const bool wifi_ok = wifi_init_sta() == ESP_OK;
+    ESP_ERROR_CHECK(camera_init_finish());
+    // 先抓一帧再打印宽高和像素格式（不同 esp32-camera 版本不再提供 status.framesize_width/height）
+    camera_fb_t* fb0 = esp_camera_fb_get();
+    if (fb0) {
+        // 上电到第一帧可用：机器人经常断电重启，启动耗时看这一行
+        ESP_LOGI(TAG, "First frame %lld ms after power-on", (long long)(esp_timer_get_time() / 1000));
+        ESP_LOGI(TAG, "Camera started. FrameSize=%dx%d, fmt=%d", fb0->width, fb0->height, (int)fb0->format);
+        esp_camera_fb_return(fb0);
+    } else {
+        ESP_LOGW(TAG, "Camera started but first frame is NULL");
+    }
+
+    latency_trace_reset();
+    frame_ring_init(&s_ring, FRAME_RING_DEPTH, FRAME_RING_LATEST, ring_release_fb, NULL);
 
-        // 可视情况适当让出 CPU
-        // vTaskDelay(1);
+    // 视觉任务先建好，采集任务才能通知它
+    xTaskCreatePinnedToCore(vision_task, "vision", 4096, NULL, 5, &s_vision_task, VISION_CORE);
+    xTaskCreatePinnedToCore(capture_task, "capture", 3072, NULL, 6, NULL, CAPTURE_CORE);
+
+    if (wifi_ok) {
+        ESP_ERROR_CHECK(stream_server_start(&s_server, CONFIG_LINE_STREAM_CORE));
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,214 @@
+#include <string.h>
+#include "line_fit.h"
+
+// 直线参数化 rho = x * cos(t) + y * sin(t)；x = a + b * y 对应 t = -atan(b)
+// theta_i = -45° + 3° * i，Q14 定点：round(cos / sin * 16384)
+static const int16_t s_cos_q14[LINE_FIT_ANGLES] = {
+    11585, 12176, 12733, 13255, 13741, 14189, 14598, 14968, 15296, 15582, 15826,
+    16026, 16182, 16294, 16362, 16384, 16362, 16294, 16182, 16026, 15826, 15582,
+    15296, 14968, 14598, 14189, 13741, 13255, 12733, 12176, 11585,
+};
+static const int16_t s_sin_q14[LINE_FIT_ANGLES] = {
+    -11585, -10963, -10311, -9630, -8923, -8192, -7438, -6664, -5872, -5063, -4240,
+    -3406, -2563, -1713, -857, 0, 857, 1713, 2563, 3406, 4240, 5063,
+    5872, 6664, 7438, 8192, 8923, 9630, 10311, 10963, 11585,
+};
+
+void line_fit_init(line_fit_t *lf, uint16_t width, uint16_t height)
+{
+    lf->width = width;
+    lf->height = height;
+    lf->inlier_tol = 2;
+    lf->ransac_iters = 16;
+    lf->min_votes = 8;
+    lf->seed = 0x1234567u;
+
+    // ±45° 内 rho 的范围：[-(h-1)*sin45, (w-1) + (h-1)*sin45]
+    const int diag = ((height - 1) * s_cos_q14[0] + (1 << 14) - 1) >> 14;
+    const int range = (width - 1) + 2 * diag + 1;
+    lf->rho_min = (int16_t)-diag;
+    lf->rho_shift = 0;
+    while ((range >> lf->rho_shift) >= LINE_FIT_RHO_BINS) {
+        lf->rho_shift++;
+    }
+}
+
+static inline uint32_t lcg(line_fit_t *lf)
+{
+    lf->seed = lf->seed * 1664525u + 1013904223u;
+    return lf->seed >> 8;
+}
+
+// 对 |x - (a + b * y)| <= tol 的点做最小二乘，b 为 Q16；返回内点数
+static int refit(const line_fit_point_t *pts, int n, int32_t x0, int32_t y0, int32_t b_q16, int tol,
+                 line_fit_result_t *out)
+{
+    const int32_t tol_q16 = tol << 16;
+    float sy = 0, sx = 0, syy = 0, sxy = 0;
+    int m = 0;
+    for (int i = 0; i < n; ++i) {
+        const int32_t d = (pts[i].x - x0) * 65536 - b_q16 * (pts[i].y - y0);
+        if (d > tol_q16 || d < -tol_q16) {
+            continue;
+        }
+        const float x = pts[i].x, y = pts[i].y;
+        sy += y;
+        sx += x;
+        syy += y * y;
+        sxy += y * x;
+        m++;
+    }
+    const float den = m * syy - sy * sy;
+    if (m < 2 || den == 0.0f) {
+        return 0;
+    }
+    out->slope = (m * sxy - sy * sx) / den;
+    out->intercept = (sx - out->slope * sy) / m;
+    return m;
+}
+
+bool line_fit_run(line_fit_t *lf, const line_fit_point_t *pts, int n, line_fit_result_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (n > LINE_FIT_MAX_POINTS) {
+        n = LINE_FIT_MAX_POINTS;
+    }
+    if (n < 2) {
+        return false;
+    }
+
+    // 投票：每个点每个角度一次乘加，全部整数
+    memset(lf->votes, 0, sizeof(lf->votes));
+    const int shift = lf->rho_shift;
+    const int rho_min = lf->rho_min;
+    for (int i = 0; i < n; ++i) {
+        const int32_t x = pts[i].x, y = pts[i].y;
+        uint16_t *v = lf->votes;
+        for (int a = 0; a < LINE_FIT_ANGLES; ++a, v += LINE_FIT_RHO_BINS) {
+            const int rho = (x * s_cos_q14[a] + y * s_sin_q14[a] + (1 << 13)) >> 14;
+            v[(rho - rho_min) >> shift]++;
+        }
+    }
+
+    int best = 0, best_a = 0, best_r = 0;
+    for (int a = 0; a < LINE_FIT_ANGLES; ++a) {
+        const uint16_t *v = lf->votes + a * LINE_FIT_RHO_BINS;
+        for (int r = 0; r < LINE_FIT_RHO_BINS; ++r) {
+            if (v[r] > best) {
+                best = v[r];
+                best_a = a;
+                best_r = r;
+            }
+        }
+    }
+    out->peak_votes = (uint16_t)best;
+    if (best < lf->min_votes) {
+        return false;
+    }
+
+    // Hough 内点：到峰值直线的距离不超过 tol 加半格量化误差（Q14 比较）
+    const int32_t c = s_cos_q14[best_a], s = s_sin_q14[best_a];
+    const int32_t rho_q14 = (rho_min + (best_r << shift)) * 16384 + ((1 << shift) << 13);
+    const int32_t tol_q14 = (lf->inlier_tol << 14) + ((1 << shift) << 13);
+    int m = 0;
+    for (int i = 0; i < n; ++i) {
+        const int32_t d = pts[i].x * c + pts[i].y * s - rho_q14;
+        if (d <= tol_q14 && d >= -tol_q14) {
+            lf->inlier_idx[m++] = (uint16_t)i;
+        }
+    }
+    if (m < 2) {
+        return false;
+    }
+
+    // 初值：Hough 峰值直线，x = rho / cos - tan * y，换成过 (x0, y0) 斜率 b 的形式
+    int32_t b_q16 = -s * 65536 / c;
+    int32_t y0 = 0;
+    int32_t x0 = (int32_t)(((int64_t)rho_q14 + (c >> 1)) / c);
+    int tol = lf->inlier_tol + (1 << shift) / 2;
+
+    // RANSAC：在 Hough 内点里取两点、数内点，交叉线的点进不来；最后按胜出的直线在全部点上重拟合
+    if (lf->ransac_iters) {
+        int best_cnt = 0;
+        const int32_t tol_q16 = lf->inlier_tol << 16;
+        for (int it = 0; it < lf->ransac_iters; ++it) {
+            const line_fit_point_t *p1 = &pts[lf->inlier_idx[lcg(lf) % m]];
+            const line_fit_point_t *p2 = &pts[lf->inlier_idx[lcg(lf) % m]];
+            const int dy = p2->y - p1->y;
+            if (dy == 0) {
+                continue;
+            }
+            // 斜率超出 ±2 的样本不可能在投票角度范围内，也避免下面 b * dy 溢出
+            const int32_t b = (p2->x - p1->x) * 65536 / dy;
+            if (b > (2 << 16) || b < -(2 << 16)) {
+                continue;
+            }
+            int cnt = 0;
+            for (int j = 0; j < m; ++j) {
+                const line_fit_point_t *p = &pts[lf->inlier_idx[j]];
+                const int32_t d = (p->x - p1->x) * 65536 - b * (p->y - p1->y);
+                cnt += (d <= tol_q16 && d >= -tol_q16);
+            }
+            if (cnt > best_cnt) {
+                best_cnt = cnt;
+                b_q16 = b;
+                x0 = p1->x;
+                y0 = p1->y;
+                tol = lf->inlier_tol;
+            }
+        }
+    }
+
+    const int inliers = refit(pts, n, x0, y0, b_q16, tol, out);
+    if (!inliers) {
+        return false;
+    }
+    out->inliers = (uint16_t)inliers;
+    out->confidence = (float)inliers / n;
+    out->valid = true;
+    return true;
+}
+
+int line_fit_run_centers(const bin_image_t *img, int row_step, int min_w, int max_w,
+                         line_fit_point_t *pts, int max_pts)
+{
+    if (row_step < 1) {
+        row_step = 1;
+    }
+    int n = 0;
+    for (int y = 0; y < img->height && n < max_pts; y += row_step) {
+        const uint32_t *r = img->bits + (size_t)y * img->words_per_row;
+        int start = -1;
+        uint32_t prev = 0;
+        for (int i = 0; i < img->words_per_row && n < max_pts; ++i) {
+            // 跳变位：和左边像素不同的位置；段内全 0 / 全 1 的字一次跳过
+            uint32_t t = r[i] ^ ((r[i] << 1) | (prev >> 31));
+            prev = r[i];
+            while (t) {
+                const int x = i * 32 + __builtin_ctz(t);
+                t &= t - 1;
+                if (start < 0) {
+                    start = x;
+                    continue;
+                }
+                const int w = x - start;
+                if (w >= min_w && w <= max_w && n < max_pts) {
+                    pts[n].x = (int16_t)((start + x - 1) / 2);
+                    pts[n].y = (int16_t)y;
+                    n++;
+                }
+                start = -1;
+            }
+        }
+        // 宽度是 32 的倍数时，延伸到行尾的段没有结束跳变，在这里收尾
+        if (start >= 0 && start < img->width) {
+            const int w = img->width - start;
+            if (w >= min_w && w <= max_w && n < max_pts) {
+                pts[n].x = (int16_t)((start + img->width - 1) / 2);
+                pts[n].y = (int16_t)y;
+                n++;
+            }
+        }
+    }
+    return n;
+}
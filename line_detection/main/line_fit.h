@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bin_image.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 鲁棒直线拟合：定点 Hough 投票先找主方向（交叉线、反光只占少数票），
+// 再对内点最小二乘（可选先做 RANSAC 精修）
+//
+// 只在 [-45°, +45°] 内投票，即 |slope| <= 1 的近竖直线，巡线相机里线总是这样
+// sin/cos 表是 const 数组，在 flash 里；投票缓冲大小固定，不随点数或图像尺寸增长
+
+#define LINE_FIT_ANGLES     31          // -45°..+45°，3° 一格
+#define LINE_FIT_RHO_BINS   256         // rho 分辨率按图像尺寸自动取 1/2/4... 像素
+#define LINE_FIT_MAX_POINTS 1024        // 每帧最多处理的点数，多出的忽略
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+} line_fit_point_t;
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t  inlier_tol;                // 内点距离门限（像素）
+    uint8_t  ransac_iters;              // RANSAC 迭代次数，0 表示只用 Hough 内点直接拟合
+    uint16_t min_votes;                 // 峰值票数下限，低于它认为没有线
+    uint8_t  rho_shift;                 // rho 量化：每格 1 << rho_shift 像素
+    int16_t  rho_min;                   // 第 0 格对应的 rho（像素）
+    uint32_t seed;                      // RANSAC 取样用的 LCG 状态
+    uint16_t votes[LINE_FIT_ANGLES * LINE_FIT_RHO_BINS];   // 约 16KB，跟着结构体放，调用者决定放内部 RAM
+    uint16_t inlier_idx[LINE_FIT_MAX_POINTS];              // Hough 内点下标，RANSAC 从里面取样
+} line_fit_t;
+
+typedef struct {
+    bool     valid;
+    float    slope;                     // 与 line_track 相同：x = intercept + slope * y
+    float    intercept;
+    float    confidence;                // 内点占全部输入点的比例 [0, 1]
+    uint16_t inliers;
+    uint16_t peak_votes;                // Hough 峰值票数
+} line_fit_result_t;
+
+/**
+ * @brief 按图像尺寸初始化（决定 rho 量化），填默认参数
+ */
+void line_fit_init(line_fit_t *lf, uint16_t width, uint16_t height);
+
+/**
+ * @brief 拟合一组点
+ *
+ * @param pts 点坐标，必须在 [0, width) x [0, height) 内
+ * @param n   点数
+ *
+ * @return out->valid
+ */
+bool line_fit_run(line_fit_t *lf, const line_fit_point_t *pts, int n, line_fit_result_t *out);
+
+/**
+ * @brief 从二值图里取点：每隔 row_step 行，每段宽度在 [min_w, max_w] 内的前景连续段取左右边缘的中点
+ *
+ * 按位扫描，只在跳变处停下；过宽的段（大片阴影）直接丢掉
+ *
+ * @return 写入 pts 的点数（不超过 max_pts）
+ */
+int line_fit_run_centers(const bin_image_t *img, int row_step, int min_w, int max_w,
+                         line_fit_point_t *pts, int max_pts);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,110 @@
+#include <string.h>
+#include <math.h>
+#include "line_predict.h"
+
+void line_predict_init(line_predict_t *lp, const line_track_config_t *cfg)
+{
+    memset(lp, 0, sizeof(*lp));
+    lp->min_half = cfg->min_width * 2 + 4;
+    lp->alpha = 0.5f;
+    lp->beta = 0.1f;
+    lp->lock_frames = 3;
+    lp->min_rows = (cfg->row_count + 1) / 2 < 2 ? 2 : (cfg->row_count + 1) / 2;
+    lp->width = cfg->width;
+    lp->half = cfg->width;
+    lp->ref_y = cfg->rows[cfg->row_count - 1];
+}
+
+static bool trusted(const line_predict_t *lp, const line_track_result_t *r)
+{
+    return r->valid && r->rows_found >= lp->min_rows && r->rows_clipped == 0;
+}
+
+static void lose(line_predict_t *lp)
+{
+    lp->locked = false;
+    lp->hits = 0;
+    lp->half = lp->width;
+}
+
+bool line_predict_process(line_predict_t *lp, const line_track_config_t *cfg, const uint8_t *gray,
+                          line_track_result_t *out)
+{
+    line_track_config_t c = *cfg;
+    const float px = lp->x + lp->vx;
+    const float ps = lp->slope + lp->vslope;
+    uint32_t pixels = 0;
+    bool windowed = false, rescanned = false;
+
+    lp->frames++;
+    if (lp->locked && lp->half < lp->width) {
+        for (int i = 0; i < c.row_count; ++i) {
+            const float cx = px + ps * (c.rows[i] - lp->ref_y);
+            lp->win[i].lo = (int16_t)lroundf(cx - lp->half);
+            lp->win[i].hi = (int16_t)lroundf(cx + lp->half + 1);
+        }
+        c.windows = lp->win;
+        line_track_process(&c, gray, out);
+        pixels = out->pixels;
+        windowed = true;
+        if (!trusted(lp, out)) {
+            // 窗口里没看清：这一帧马上整行再扫，不等下一帧
+            rescanned = true;
+            lp->rescans++;
+        }
+    }
+    if (!windowed || rescanned) {
+        c.windows = NULL;
+        line_track_process(&c, gray, out);
+        out->pixels += pixels;
+    }
+
+    if (!out->valid || out->rows_found < lp->min_rows) {
+        lose(lp);
+        return out->valid;
+    }
+
+    const float mx = out->intercept + out->slope * lp->ref_y;
+    if (!lp->locked || rescanned) {
+        // 首次锁定或预测失败：直接用测量值，速度清零，重新数稳定帧
+        lp->locked = true;
+        lp->x = mx;
+        lp->slope = out->slope;
+        lp->vx = 0;
+        lp->vslope = 0;
+        lp->hits = 0;
+        lp->half = lp->width;
+    } else {
+        const float rx = mx - px;
+        const float rs = out->slope - ps;
+        lp->x = px + lp->alpha * rx;
+        lp->vx += lp->beta * rx;
+        lp->slope = ps + lp->alpha * rs;
+        lp->vslope += lp->beta * rs;
+    }
+    if (lp->hits < 255) {
+        lp->hits++;
+    }
+
+    if (lp->hits >= lp->lock_frames) {
+        // 窗口下限：线宽 + 速度带来的不确定量，保证下一帧线整段落在窗口里
+        int line_w = 0, n = 0;
+        for (int i = 0; i < c.row_count; ++i) {
+            if (out->row[i].left >= 0) {
+                line_w += out->row[i].right - out->row[i].left + 1;
+                n++;
+            }
+        }
+        const float span = (float)(lp->ref_y - c.rows[0]);
+        float floor_half = (n ? (float)line_w / n : 0) + 4 + fabsf(lp->vx) + fabsf(lp->vslope) * span;
+        if (floor_half < lp->min_half) {
+            floor_half = lp->min_half;
+        }
+        uint16_t half = lp->half / 2;
+        if (half < floor_half) {
+            half = (uint16_t)ceilf(floor_half);
+        }
+        lp->half = half < lp->width ? half : lp->width;
+    }
+    return true;
+}
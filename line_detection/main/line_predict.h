@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "line_track.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 预测跟踪窗口：对线的位置（最底扫描行处的 x）和斜率各做一个 α-β（匀速）滤波，
+// 下一帧每个扫描行只扫预测位置附近的一段列
+//
+// 连续稳定命中后窗口逐帧减半，直到 min_half；丢线、段被窗口截断或命中行数不足时
+// 当帧立刻整行重扫一次，窗口放回整行，所以窗口收窄不会让某一帧丢线
+
+typedef struct {
+    // 参数
+    uint16_t min_half;                      // 稳态时窗口半宽（像素）
+    float    alpha;                         // 位置修正增益 (0, 1]
+    float    beta;                          // 速度修正增益 (0, 1]
+    uint8_t  lock_frames;                   // 连续命中多少帧后开始收窄
+    uint8_t  min_rows;                      // 命中行数少于它视为不可信
+
+    // 状态
+    bool     locked;
+    uint8_t  hits;
+    uint16_t half;                          // 当前窗口半宽，>= width 表示整行
+    uint16_t width;
+    uint16_t ref_y;                         // 位置参考行（最底扫描行）
+    float    x;                             // ref_y 处线中心
+    float    vx;                            // 每帧位移
+    float    slope;                         // x = x + slope * (y - ref_y)
+    float    vslope;
+    line_track_window_t win[LINE_TRACK_MAX_ROWS];
+
+    // 统计
+    uint32_t frames;
+    uint32_t rescans;                       // 窗口内没找到、当帧整行重扫的次数
+} line_predict_t;
+
+/**
+ * @brief 按扫描配置初始化，默认稳态半宽为 max_width 的两倍
+ */
+void line_predict_init(line_predict_t *lp, const line_track_config_t *cfg);
+
+/**
+ * @brief 代替 line_track_process：窗口扫描，必要时整行重扫，再更新预测
+ *
+ * out->pixels 是本帧所有扫描（含重扫）实际读过的像素数
+ *
+ * @return out->valid
+ */
+bool line_predict_process(line_predict_t *lp, const line_track_config_t *cfg, const uint8_t *gray,
+                          line_track_result_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,150 @@
+#include <string.h>
+#include <math.h>
+#include "line_track.h"
+
+void line_track_default_config(line_track_config_t *cfg, uint16_t width, uint16_t height, uint8_t row_count)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    if (row_count > LINE_TRACK_MAX_ROWS) row_count = LINE_TRACK_MAX_ROWS;
+    if (row_count == 0) row_count = 1;
+    cfg->width = width;
+    cfg->height = height;
+    cfg->stride = width;
+    cfg->row_count = row_count;
+    cfg->threshold = 90;
+    cfg->min_width = width / 64 + 1;        // QQVGA 约 3 像素
+    cfg->max_width = width / 3;
+
+    // 下半幅均匀取行，最后一行贴着图像底部
+    const uint16_t top = height / 2;
+    const uint16_t span = height - 1 - top;
+    for (int i = 0; i < row_count; ++i) {
+        cfg->rows[i] = (row_count == 1) ? (height - 1) : (uint16_t)(top + span * i / (row_count - 1));
+    }
+}
+
+// 在一行里找最宽的黑色连续段，边扫描边累计加权质心
+// hist 非 NULL 时同一遍里顺带统计直方图，整帧只扫一遍
+static bool scan_row(const uint8_t *p, int width, uint8_t th, int min_w, int max_w, uint32_t *hist, line_track_row_t *out)
+{
+    int best_w = 0, best_l = -1;
+    uint32_t best_sw = 0, best_swx = 0;
+
+    int run_l = -1;
+    uint32_t sw = 0, swx = 0;
+    for (int x = 0; x <= width; ++x) {
+        bool dark = false;
+        if (x < width) {
+            const uint8_t v = p[x];
+            if (hist) {
+                hist[v]++;
+            }
+            dark = v < th;
+            if (dark) {
+                // 越黑权重越大，+1 保证阈值边缘像素也有权重
+                const uint32_t w = (uint32_t)(th - v) + 1;
+                if (run_l < 0) {
+                    run_l = x;
+                    sw = 0;
+                    swx = 0;
+                }
+                sw += w;
+                swx += w * (uint32_t)x;
+            }
+        }
+        if (!dark && run_l >= 0) {
+            const int run_w = x - run_l;
+            if (run_w >= min_w && run_w <= max_w && run_w > best_w) {
+                best_w = run_w;
+                best_l = run_l;
+                best_sw = sw;
+                best_swx = swx;
+            }
+            run_l = -1;
+        }
+    }
+
+    if (best_l < 0) {
+        out->left = -1;
+        out->right = -1;
+        out->center_q4 = -1;
+        return false;
+    }
+    out->left = (int16_t)best_l;
+    out->right = (int16_t)(best_l + best_w - 1);
+    out->center_q4 = (int16_t)((best_swx * 16 + best_sw / 2) / best_sw);
+    return true;
+}
+
+bool line_track_process(const line_track_config_t *cfg, const uint8_t *gray, line_track_result_t *out)
+{
+    const int stride = cfg->stride ? cfg->stride : cfg->width;
+
+    out->valid = false;
+    out->rows_found = 0;
+    out->rows_clipped = 0;
+    out->pixels = 0;
+    if (cfg->hist) {
+        memset(cfg->hist, 0, 256 * sizeof(uint32_t));
+    }
+
+    // 最小二乘拟合 x = a + b * y
+    float sy = 0, sx = 0, syy = 0, sxy = 0;
+    int n = 0;
+    int bottom = -1;
+
+    for (int i = 0; i < cfg->row_count; ++i) {
+        const int y = cfg->rows[i];
+        line_track_row_t *r = &out->row[i];
+        int lo = 0, hi = cfg->width;
+        if (cfg->windows) {
+            lo = cfg->windows[i].lo < 0 ? 0 : cfg->windows[i].lo;
+            hi = cfg->windows[i].hi > cfg->width ? cfg->width : cfg->windows[i].hi;
+        }
+        if (hi <= lo) {
+            r->left = r->right = r->center_q4 = -1;
+            continue;
+        }
+        out->pixels += hi - lo;
+        if (!scan_row(gray + (size_t)y * stride + lo, hi - lo, cfg->threshold, cfg->min_width, cfg->max_width, cfg->hist, r)) {
+            continue;
+        }
+        r->left += lo;
+        r->right += lo;
+        r->center_q4 += lo * 16;
+        // 段被窗口边截断时质心是偏的，这一行不用
+        if ((r->left == lo && lo > 0) || (r->right == hi - 1 && hi < cfg->width)) {
+            out->rows_clipped++;
+            r->left = r->right = r->center_q4 = -1;
+            continue;
+        }
+        const float x = r->center_q4 / 16.0f;
+        sy += y;
+        sx += x;
+        syy += (float)y * y;
+        sxy += (float)y * x;
+        n++;
+        bottom = i;
+    }
+    out->rows_found = (uint8_t)n;
+
+    if (n < 2) {
+        return false;
+    }
+
+    const float den = n * syy - sy * sy;
+    if (den == 0.0f) {
+        return false;
+    }
+    out->slope = (n * sxy - sy * sx) / den;
+    out->intercept = (sx - out->slope * sy) / n;
+
+    // 偏移按最靠下的有效扫描行计算，那里离车体最近
+    const float half_w = cfg->width * 0.5f;
+    const float x_bottom = out->intercept + out->slope * cfg->rows[bottom];
+    out->offset = (x_bottom - half_w) / half_w;
+    // y 向下增长，往前看是 y 减小，所以取 -slope
+    out->heading = atanf(-out->slope);
+    out->valid = true;
+    return true;
+}
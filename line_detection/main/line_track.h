@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 巡线引擎：只扫描若干行，找黑线边缘和质心，再拟合成 偏移 + 航向
+// 纯 C，不依赖 ESP-IDF，输入为 8bit 灰度图
+
+#define LINE_TRACK_MAX_ROWS 16
+
+typedef struct {
+    int16_t lo;                             // 搜索列范围 [lo, hi)
+    int16_t hi;
+} line_track_window_t;
+
+typedef struct {
+    uint16_t width;                         // 图像宽（像素）
+    uint16_t height;                        // 图像高（像素）
+    uint16_t stride;                        // 行跨度（字节），0 表示等于 width
+    uint8_t  row_count;                     // 实际使用的扫描行数
+    uint16_t rows[LINE_TRACK_MAX_ROWS];     // 扫描行 y 坐标，按从上到下排列
+    uint8_t  threshold;                     // 像素 < threshold 视为黑线
+    uint16_t min_width;                     // 有效线宽下限（像素），滤掉噪点
+    uint16_t max_width;                     // 有效线宽上限（像素），滤掉大块阴影
+    uint32_t *hist;                         // 可选，256 项：非 NULL 时扫描同时统计扫描行的灰度直方图（每帧清零）
+    const line_track_window_t *windows;     // 可选，row_count 项：每行只扫这一段列，NULL 扫整行
+} line_track_config_t;
+
+typedef struct {
+    int16_t left;                           // 左边缘 x，-1 表示该行没找到线
+    int16_t right;                          // 右边缘 x（含）
+    int16_t center_q4;                      // 加权质心 x，Q4 定点（x * 16）
+} line_track_row_t;
+
+typedef struct {
+    bool     valid;                         // 至少两行找到线时才有拟合结果
+    uint8_t  rows_found;
+    uint8_t  rows_clipped;                  // 找到的段贴着窗口边（线可能在窗口外），不计入拟合
+    uint32_t pixels;                        // 本帧实际读过的像素数
+    float    offset;                        // 最底扫描行处线中心相对图像中心的偏移，归一化到 [-1, 1]，右为正
+    float    heading;                       // 线相对竖直方向的夹角（弧度），前方向右弯为正
+    float    slope;                         // 拟合 x = intercept + slope * y
+    float    intercept;
+    line_track_row_t row[LINE_TRACK_MAX_ROWS];
+} line_track_result_t;
+
+/**
+ * @brief 按图像尺寸填默认配置：在下半幅均匀取 row_count 行
+ */
+void line_track_default_config(line_track_config_t *cfg, uint16_t width, uint16_t height, uint8_t row_count);
+
+/**
+ * @brief 处理一帧灰度图
+ *
+ * @param cfg  配置（rows 必须在 [0, height) 内）
+ * @param gray 灰度像素，至少 height * stride 字节
+ * @param out  结果
+ *
+ * @return out->valid
+ */
+bool line_track_process(const line_track_config_t *cfg, const uint8_t *gray, line_track_result_t *out);
+
+#ifdef __cplusplus
+}
+#endif
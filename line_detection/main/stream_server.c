@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "img_converters.h"
+
+#include "stream_server.h"
+
+static const char *TAG = "stream";
+
+#define STREAM_BOUNDARY     "lineframe"
+#define STREAM_DEFAULT_FPS  10
+#define STREAM_DEFAULT_Q    60
+#define FRAME_WAIT_MS       1000
+#define STREAM_MAX_MISSES   3       // 连续这么多次等不到帧就结束这条流，不让 httpd 任务一直挂着
+
+static const char *STREAM_CONTENT_TYPE = "multipart/x-mixed-replace;boundary=" STREAM_BOUNDARY;
+static const char *STREAM_PART_HDR = "\r\n--" STREAM_BOUNDARY "\r\nContent-Type: image/jpeg\r\n\r\n";
+
+// httpd 任务想要下一帧时置位；视觉任务 exchange 拿到令牌后才投递，
+// 所以队列里最多只有一帧，httpd 也最多占用一块 fb
+static atomic_bool s_want = false;
+static QueueHandle_t s_frame_q = NULL;
+
+typedef struct {
+    httpd_req_t *req;
+    bool failed;
+} jpg_chunk_t;
+
+bool stream_server_offer(camera_fb_t *fb)
+{
+    if (!s_frame_q || !atomic_exchange(&s_want, false)) {
+        return false;
+    }
+    // 长度 1 且只有持令牌者会投递，不会满
+    xQueueSend(s_frame_q, &fb, 0);
+    return true;
+}
+
+// 请求一帧：置令牌后等视觉任务投递
+static camera_fb_t *wait_frame(void)
+{
+    camera_fb_t *fb = NULL;
+    atomic_store(&s_want, true);
+    if (xQueueReceive(s_frame_q, &fb, pdMS_TO_TICKS(FRAME_WAIT_MS)) == pdTRUE) {
+        return fb;
+    }
+    // 超时：收回令牌；如果令牌已经被视觉任务拿走，帧马上就会到，必须收下并归还
+    if (!atomic_exchange(&s_want, false)) {
+        if (xQueueReceive(s_frame_q, &fb, pdMS_TO_TICKS(FRAME_WAIT_MS)) == pdTRUE) {
+            return fb;
+        }
+    }
+    return NULL;
+}
+
+static size_t jpg_send_chunk(void *arg, size_t index, const void *data, size_t len)
+{
+    jpg_chunk_t *j = (jpg_chunk_t *)arg;
+    if (j->failed || !data || !len) {
+        return 0;
+    }
+    if (httpd_resp_send_chunk(j->req, (const char *)data, len) != ESP_OK) {
+        j->failed = true;
+        return 0;
+    }
+    return len;
+}
+
+static int query_int(httpd_req_t *req, const char *key, int def, int lo, int hi)
+{
+    char query[64];
+    char val[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, key, val, sizeof(val)) != ESP_OK) {
+        return def;
+    }
+    int v = atoi(val);
+    if (v < lo) v = lo;
+    if (v > hi) v = hi;
+    return v;
+}
+
+static esp_err_t frame_handler(httpd_req_t *req)
+{
+    const int quality = query_int(req, "q", STREAM_DEFAULT_Q, 1, 100);
+
+    camera_fb_t *fb = wait_frame();
+    if (!fb) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no frame");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "image/jpeg");
+    httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=frame.jpg");
+
+    jpg_chunk_t j = { .req = req, .failed = false };
+    bool ok = frame2jpg_cb(fb, quality, jpg_send_chunk, &j);
+    esp_camera_fb_return(fb);
+
+    if (!ok || j.failed) {
+        ESP_LOGW(TAG, "frame encode/send failed");
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static esp_err_t stream_handler(httpd_req_t *req)
+{
+    const int fps = query_int(req, "fps", STREAM_DEFAULT_FPS, 1, 30);
+    const int quality = query_int(req, "q", STREAM_DEFAULT_Q, 1, 100);
+    const int64_t period_us = 1000000 / fps;
+
+    esp_err_t res = httpd_resp_set_type(req, STREAM_CONTENT_TYPE);
+    if (res != ESP_OK) {
+        return res;
+    }
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    ESP_LOGI(TAG, "stream start: fps=%d q=%d", fps, quality);
+
+    int64_t next_us = esp_timer_get_time();
+    int sent = 0;
+    int misses = 0;
+    while (true) {
+        // 限帧：没到时间就不领帧，视觉任务照常自己归还
+        int64_t now = esp_timer_get_time();
+        if (now < next_us) {
+            vTaskDelay(pdMS_TO_TICKS((next_us - now) / 1000) + 1);
+        }
+        next_us += period_us;
+        if (next_us < esp_timer_get_time()) {
+            next_us = esp_timer_get_time();
+        }
+
+        camera_fb_t *fb = wait_frame();
+        if (!fb) {
+            // 视觉任务没在出帧（相机停了或一直丢帧），这期间也探不到客户端断开
+            if (++misses >= STREAM_MAX_MISSES) {
+                ESP_LOGW(TAG, "no frame in %d waits, ending stream", misses);
+                break;
+            }
+            continue;
+        }
+        misses = 0;
+
+        res = httpd_resp_send_chunk(req, STREAM_PART_HDR, strlen(STREAM_PART_HDR));
+        jpg_chunk_t j = { .req = req, .failed = (res != ESP_OK) };
+        bool ok = !j.failed && frame2jpg_cb(fb, quality, jpg_send_chunk, &j);
+        esp_camera_fb_return(fb);
+
+        if (!ok || j.failed) {
+            break;
+        }
+        sent++;
+    }
+
+    ESP_LOGI(TAG, "stream end after %d frames", sent);
+    return ESP_FAIL;
+}
+
+esp_err_t stream_server_start(httpd_handle_t *out, int core_id)
+{
+    if (!s_frame_q) {
+        s_frame_q = xQueueCreate(1, sizeof(camera_fb_t *));
+        if (!s_frame_q) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // esp_http_server 只有一个任务跑 handler：/stream 在发时 /frame 要排到流结束之后，
+    // 加 max_open_sockets 也没用，只是多排几个连接
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.core_id = core_id;
+    config.stack_size = 6144;           // jpge 编码器在栈上有不少状态
+
+    httpd_handle_t server = NULL;
+    esp_err_t err = httpd_start(&server, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "httpd_start failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    const httpd_uri_t stream_uri = { .uri = "/stream", .method = HTTP_GET, .handler = stream_handler };
+    const httpd_uri_t frame_uri = { .uri = "/frame", .method = HTTP_GET, .handler = frame_handler };
+    httpd_register_uri_handler(server, &stream_uri);
+    httpd_register_uri_handler(server, &frame_uri);
+
+    ESP_LOGI(TAG, "serving /stream and /frame on port %d", config.server_port);
+    *out = server;
+    return ESP_OK;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_camera.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 调试用图传：/stream（multipart MJPEG）和 /frame（单张 JPEG）
+// 编码在 httpd 任务里做，frame2jpg_cb 直接写 socket，不分配整帧 JPEG 缓冲
+// 查询参数：fps=1..30（仅 /stream），q=1..100（JPEG 质量）
+// 同一时间只服务一个请求：有 /stream 在发时 /frame 会等到流结束；
+// 连续 3 次（约 3 s 以上）等不到帧时 /stream 自己断开
+
+/**
+ * @brief 启动 httpd 并注册 /stream、/frame
+ *
+ * @param core_id httpd 任务绑定的核，避开视觉任务所在核
+ */
+esp_err_t stream_server_start(httpd_handle_t *out, int core_id);
+
+/**
+ * @brief 视觉任务处理完一帧后调用
+ *
+ * 有客户端在等下一帧时接管 fb（编码完由 httpd 任务归还给驱动），返回 true；
+ * 否则返回 false，调用方自己 esp_camera_fb_return。不会阻塞。
+ */
+bool stream_server_offer(camera_fb_t *fb);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,6 +4,8 @@
 #ifndef JPEG_ENCODER_H
 #define JPEG_ENCODER_H
 
+#include <stddef.h>
+
 namespace jpge
 {
     typedef unsigned char  uint8;
@@ -47,7 +49,7 @@ namespace jpge
         public:
             virtual ~output_stream() { };
             virtual bool put_buf(const void* Pbuf, int len) = 0;
-            virtual uint get_size() const = 0;
+            virtual size_t get_size() const = 0;
     };
     
     // Lower level jpeg_encoder class - useful if more control is needed than the above helper functions.
@@ -32,6 +32,9 @@
 #ifndef ESP_CACHE_MSYNC_FLAG_DIR_M2C
 #define ESP_CACHE_MSYNC_FLAG_DIR_M2C 0
 #endif
+#ifndef ESP_CACHE_MSYNC_FLAG_DIR_C2M
+#define ESP_CACHE_MSYNC_FLAG_DIR_C2M 0
+#endif
 #if CONFIG_IDF_TARGET_ESP32
 #include "esp32/rom/ets_sys.h"  // will be removed in idf v5.0
 #elif CONFIG_IDF_TARGET_ESP32S2
@@ -59,6 +62,28 @@ static cam_obj_t *cam_obj = NULL;
 static volatile bool g_psram_dma_mode = CAMERA_PSRAM_DMA_ENABLED;
 static portMUX_TYPE g_psram_dma_lock = portMUX_INITIALIZER_UNLOCKED;
 
+/*
+ * The stats are bumped from the VSYNC/EOF ISRs, cam_task and whichever tasks call
+ * esp_camera_fb_get(), on both cores, so every update goes through this lock.
+ * The _SAFE variants work from ISR and task context alike.
+ */
+static portMUX_TYPE g_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+#define CAM_STAT_INC(cam, field) do { \
+        portENTER_CRITICAL_SAFE(&g_stats_lock); \
+        (cam)->stats.field++; \
+        portEXIT_CRITICAL_SAFE(&g_stats_lock); \
+    } while (0)
+
+// the mode the next cam_config() would pick up, PSRAM DMA only exists on the S2/S3
+static bool cam_psram_mode_wanted(void)
+{
+#if CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3
+    return g_psram_dma_mode;
+#else
+    return false;
+#endif
+}
+
 /* At top of cam_hal.c – one switch for noisy ISR prints */
 #ifndef CAM_LOG_SPAM_EVERY_FRAME
 #define CAM_LOG_SPAM_EVERY_FRAME 0   /* set to 1 to restore old behaviour */
@@ -105,6 +130,21 @@ static inline void cam_drop_psram_cache(void *addr, size_t len)
                     ESP_CACHE_MSYNC_FLAG_DIR_M2C | ESP_CACHE_MSYNC_FLAG_INVALIDATE);
 }
 
+/*
+ * Write back CPU data cache lines covering a PSRAM region the CPU has just
+ * written, so a later cam_drop_psram_cache() over it loses nothing.
+ */
+static inline void cam_sync_psram_cache(void *addr, size_t len)
+{
+    size_t line = dcache_line_size();
+    if (line == 0) {
+        line = 32;
+    }
+    uintptr_t start = (uintptr_t)addr & ~(line - 1);
+    size_t sync_len = (len + ((uintptr_t)addr - start) + line - 1) & ~(line - 1);
+    esp_cache_msync((void *)start, sync_len, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+}
+
 /* Throttle repeated warnings printed from tight loops / ISRs.
  *
  * counter – static DRAM/IRAM uint16_t you pass in
@@ -212,39 +252,78 @@ static int cam_verify_jpeg_eoi(const uint8_t *inbuf, uint32_t length, bool searc
     return -1;
 }
 
+static inline void cam_frame_release(int pos)
+{
+    atomic_fetch_or(&cam_obj->free_mask, 1u << pos);
+}
+
+static inline void cam_frame_claim(int pos)
+{
+    atomic_fetch_and(&cam_obj->free_mask, ~(1u << pos));
+}
+
+static inline int cam_frame_index(const camera_fb_t *fb)
+{
+    // frames[] is contiguous with fb as the first member, so the slot is a subtraction away
+    uintptr_t off = (uintptr_t)fb - (uintptr_t)cam_obj->frames;
+    size_t pos = off / sizeof(cam_frame_t);
+    if (fb == NULL || (uintptr_t)fb < (uintptr_t)cam_obj->frames || pos >= cam_obj->frame_cnt
+        || off % sizeof(cam_frame_t) != 0) {
+        return -1;
+    }
+    return (int)pos;
+}
+
 static bool cam_get_next_frame(int * frame_pos)
 {
-    if(!cam_obj->frames[*frame_pos].en){
-        for (int x = 0; x < cam_obj->frame_cnt; x++) {
-            if (cam_obj->frames[x].en) {
-                *frame_pos = x;
-                return true;
-            }
-        }
-    } else {
+    uint32_t free_mask = atomic_load(&cam_obj->free_mask);
+    if (free_mask & (1u << *frame_pos)) {
         return true;
     }
-    return false;
+    if (free_mask == 0) {
+        return false;
+    }
+    *frame_pos = __builtin_ctz(free_mask);
+    return true;
 }
 
-static bool cam_start_frame(int * frame_pos)
+static bool cam_start_frame(int * frame_pos, const cam_event_msg_t *vsync)
 {
     if (cam_get_next_frame(frame_pos)) {
         if(ll_cam_start(cam_obj, *frame_pos)){
             // Vsync the frame manually
             ll_cam_do_vsync(cam_obj);
-            uint64_t us = (uint64_t)esp_timer_get_time();
+            // stamp with the VSYNC interrupt itself, not with whenever cam_task got here
+            uint64_t us = (uint64_t)vsync->us;
             cam_obj->frames[*frame_pos].fb.timestamp.tv_sec = us / 1000000UL;
             cam_obj->frames[*frame_pos].fb.timestamp.tv_usec = us % 1000000UL;
+            cam_obj->frames[*frame_pos].fb.seq = vsync->seq;
+            cam_obj->frames[*frame_pos].vsync_us = vsync->us;
+            cam_obj->frames[*frame_pos].eof_us = 0;
+            cam_obj->frames[*frame_pos].take_us = 0;
+            cam_obj->frames[*frame_pos].fb.width = cam_obj->fb_width;
+            cam_obj->frames[*frame_pos].fb.height = cam_obj->fb_height;
+            cam_obj->crop_row = 0;
             return true;
         }
+    } else {
+        CAM_STAT_INC(cam_obj, drop_no_fb);
     }
     return false;
 }
 
-void IRAM_ATTR ll_cam_send_event(cam_obj_t *cam, cam_event_t cam_event, BaseType_t * HPTaskAwoken)
+void IRAM_ATTR ll_cam_send_event(cam_obj_t *cam, cam_event_t cam_event, int64_t isr_us, BaseType_t * HPTaskAwoken)
 {
-    if (xQueueSendFromISR(cam->event_queue, (void *)&cam_event, HPTaskAwoken) != pdTRUE) {
+    cam_event_msg_t msg = {
+        .type = cam_event,
+        .us = isr_us,
+    };
+    if (cam_event == CAM_VSYNC_EVENT) {
+        msg.seq = ++cam->vsync_cnt;
+        CAM_STAT_INC(cam, vsyncs);
+    }
+    if (xQueueSendFromISR(cam->event_queue, (void *)&msg, HPTaskAwoken) != pdTRUE) {
+        CAM_STAT_INC(cam, event_overflow);
         ll_cam_stop(cam);
         cam->state = CAM_STATE_IDLE;
 #if CAM_LOG_SPAM_EVERY_FRAME
@@ -257,6 +336,50 @@ void IRAM_ATTR ll_cam_send_event(cam_obj_t *cam, cam_event_t cam_event, BaseType
     }
 }
 
+static void cam_emit_slice(const uint8_t *buf, size_t offset, size_t len)
+{
+    const size_t row_bytes = cam_obj->fb_width * cam_obj->fb_bytes_per_pixel;
+    camera_slice_t slice = {
+        .buf = buf,
+        .len = len,
+        .width = cam_obj->fb_width,
+        .height = cam_obj->fb_height,
+        .y = offset / row_bytes,
+        .rows = len / row_bytes,
+        .frame = cam_obj->slice_frame,
+    };
+    cam_obj->slice_cb(&slice, cam_obj->slice_arg);
+}
+
+//Bytes cam_copy_cropped() will write for the next DMA half-buffer
+static size_t cam_cropped_len(void)
+{
+    const size_t line_in = cam_obj->width * cam_obj->in_bytes_per_pixel * cam_obj->dma_bytes_per_item;
+    const size_t first = cam_obj->crop_row;
+    const size_t last = first + cam_obj->dma_half_buffer_size / line_in;
+    const size_t step = cam_obj->row_step;
+    // kept rows in [first, last): multiples of step
+    const size_t rows = (last + step - 1) / step - (first + step - 1) / step;
+    return rows * cam_obj->fb_width * cam_obj->fb_bytes_per_pixel;
+}
+
+//Copy the kept columns of every kept row of one DMA half-buffer; out may be half itself
+static size_t cam_copy_cropped(uint8_t *out, const uint8_t *half)
+{
+    const size_t pixel_in = cam_obj->in_bytes_per_pixel * cam_obj->dma_bytes_per_item;
+    const size_t line_in = cam_obj->width * pixel_in;
+    const size_t skip = cam_obj->crop_x * pixel_in;
+    const size_t keep = cam_obj->fb_width * pixel_in;
+    const uint8_t *end = half + cam_obj->dma_half_buffer_size;
+    size_t len = 0;
+    for (const uint8_t *line = half; line < end; line += line_in) {
+        if (cam_obj->crop_row++ % cam_obj->row_step == 0) {
+            len += ll_cam_memcpy(cam_obj, out + len, line + skip, keep);
+        }
+    }
+    return len;
+}
+
 //Copy fram from DMA dma_buffer to fram dma_buffer
 static void cam_task(void *arg)
 {
@@ -264,18 +387,29 @@ static void cam_task(void *arg)
     int frame_pos = 0;
     cam_obj->state = CAM_STATE_IDLE;
     cam_event_t cam_event = 0;
+    cam_event_msg_t msg;
+    int64_t last_eof_us = 0;
 
     xQueueReset(cam_obj->event_queue);
 
     while (1) {
-        xQueueReceive(cam_obj->event_queue, (void *)&cam_event, portMAX_DELAY);
+        xQueueReceive(cam_obj->event_queue, (void *)&msg, portMAX_DELAY);
+        cam_event = msg.type;
+        if (cam_event == CAM_STOP_SYNC_EVENT) {
+            // every event the ISRs queued before cam_stop() has been handled
+            xSemaphoreGive(cam_obj->stop_sync);
+            continue;
+        }
+        if (cam_event == CAM_IN_SUC_EOF_EVENT) {
+            last_eof_us = msg.us;
+        }
         DBG_PIN_SET(1);
         switch (cam_obj->state) {
 
             case CAM_STATE_IDLE: {
                 if (cam_event == CAM_VSYNC_EVENT) {
                     //DBG_PIN_SET(1);
-                    if(cam_start_frame(&frame_pos)){
+                    if(cam_start_frame(&frame_pos, &msg)){
                         cam_obj->frames[frame_pos].fb.len = 0;
                         cam_obj->state = CAM_STATE_READ_BUF;
                     }
@@ -290,15 +424,24 @@ static void cam_task(void *arg)
 
                 if (cam_event == CAM_IN_SUC_EOF_EVENT) {
                     if(!cam_obj->psram_mode){
+                        if (cam_obj->cropped) {
+                            pixels_per_dma = cam_cropped_len();
+                        }
                         if (cam_obj->fb_size < (frame_buffer_event->len + pixels_per_dma)) {
                             ESP_CAMERA_ETS_PRINTF(DRAM_STR("cam_hal: FB-OVF\r\n"));
+                            CAM_STAT_INC(cam_obj, drop_fb_overflow);
                             ll_cam_stop(cam_obj);
                             continue;
                         }
-                        frame_buffer_event->len += ll_cam_memcpy(cam_obj,
-                            &frame_buffer_event->buf[frame_buffer_event->len],
-                            &cam_obj->dma_buffer[(cnt % cam_obj->dma_half_buffer_cnt) * cam_obj->dma_half_buffer_size],
-                            cam_obj->dma_half_buffer_size);
+                        uint8_t *half = &cam_obj->dma_buffer[(cnt % cam_obj->dma_half_buffer_cnt) * cam_obj->dma_half_buffer_size];
+                        // without frame buffers the conversion runs in place, its output is never longer than its input
+                        uint8_t *dst = cam_obj->slice_only ? half : &frame_buffer_event->buf[frame_buffer_event->len];
+                        size_t len = cam_obj->cropped ? cam_copy_cropped(dst, half)
+                                     : ll_cam_memcpy(cam_obj, dst, half, cam_obj->dma_half_buffer_size);
+                        if (cam_obj->slice_cb) {
+                            cam_emit_slice(dst, frame_buffer_event->len, len);
+                        }
+                        frame_buffer_event->len += len;
                     } else {
                         // stop if the next DMA copy would exceed the framebuffer slot
                         // size, since we're called only after the copy occurs
@@ -307,10 +450,20 @@ static void cam_task(void *arg)
                         // cam event will be a VSYNC
                         if (cnt + 1 >= cam_obj->frame_copy_cnt) {
                             ESP_CAMERA_ETS_PRINTF(DRAM_STR("cam_hal: DMA overflow\r\n"));
+                            CAM_STAT_INC(cam_obj, drop_dma_overflow);
                             ll_cam_stop(cam_obj);
                             cam_obj->state = CAM_STATE_IDLE;
                             continue;
                         }
+                        if (cam_obj->psram_luma) {
+                            // drop Y into the part of the frame already consumed while this half-buffer is hot in cache
+                            uint8_t *half = &frame_buffer_event->buf[cnt * cam_obj->dma_half_buffer_size];
+                            uint8_t *dst = &frame_buffer_event->buf[frame_buffer_event->len];
+                            cam_drop_psram_cache(half, cam_obj->dma_half_buffer_size);
+                            size_t len = ll_cam_memcpy(cam_obj, dst, half, cam_obj->dma_half_buffer_size);
+                            cam_sync_psram_cache(dst, len);
+                            frame_buffer_event->len += len;
+                        }
                     }
 
                     //Check for JPEG SOI in the first buffer. stop if not found
@@ -337,6 +490,7 @@ static void cam_task(void *arg)
                                     CAM_WARN_THROTTLE(warn_psram_soi_cnt,
                                                       "NO-SOI - JPEG start marker missing (PSRAM)");
                                 }
+                                CAM_STAT_INC(cam_obj, drop_no_soi);
                                 ll_cam_stop(cam_obj);
                                 cam_obj->state = CAM_STATE_IDLE;
                                 continue;
@@ -352,6 +506,7 @@ static void cam_task(void *arg)
                                     CAM_WARN_THROTTLE(warn_soi_bad_cnt,
                                                       "NO-SOI - JPEG start marker missing");
                                 }
+                                CAM_STAT_INC(cam_obj, drop_no_soi);
                                 ll_cam_stop(cam_obj);
                                 cam_obj->state = CAM_STATE_IDLE;
                                 continue;
@@ -381,9 +536,13 @@ static void cam_task(void *arg)
                             cnt++;
                         }
 
-                        cam_obj->frames[frame_pos].en = 0;
+                        cam_obj->slice_frame++;
+                        // slices were the only output, the frame slot is free again right away
+                        bool send = !cam_obj->slice_only;
+                        // last EOF before this VSYNC closed the frame; not raised for non-JPEG PSRAM DMA
+                        cam_obj->frames[frame_pos].eof_us = cnt ? last_eof_us : 0;
 
-                        if (cam_obj->psram_mode) {
+                        if (cam_obj->psram_mode && !cam_obj->psram_luma) {
                             if (cam_obj->jpeg_mode) {
                                 frame_buffer_event->len = cnt * cam_obj->dma_half_buffer_size;
                             } else {
@@ -391,31 +550,40 @@ static void cam_task(void *arg)
                             }
                         } else if (!cam_obj->jpeg_mode) {
                             if (frame_buffer_event->len != cam_obj->fb_size) {
-                                cam_obj->frames[frame_pos].en = 1;
+                                send = false;
+                                CAM_STAT_INC(cam_obj, drop_size);
                                 ESP_CAMERA_ETS_PRINTF(DRAM_STR("cam_hal: FB-SIZE: %u != %u\r\n"), frame_buffer_event->len, (unsigned) cam_obj->fb_size);
                             }
                         }
-                        //send frame
-                        if(!cam_obj->frames[frame_pos].en && xQueueSend(cam_obj->frame_buffer_queue, (void *)&frame_buffer_event, 0) != pdTRUE) {
+                        //send frame; claim it first, the receiver may give it back before xQueueSend returns
+                        if (send) {
+                            cam_frame_claim(frame_pos);
+                            cam_obj->frames[frame_pos].queued_us = esp_timer_get_time();
+                            CAM_STAT_INC(cam_obj, frames);
+                        }
+                        if(send && xQueueSend(cam_obj->frame_buffer_queue, (void *)&frame_buffer_event, 0) != pdTRUE) {
                             //pop frame buffer from the queue
                             camera_fb_t * fb2 = NULL;
                             if(xQueueReceive(cam_obj->frame_buffer_queue, &fb2, 0) == pdTRUE) {
                                 //push the new frame to the end of the queue
                                 if (xQueueSend(cam_obj->frame_buffer_queue, (void *)&frame_buffer_event, 0) != pdTRUE) {
-                                    cam_obj->frames[frame_pos].en = 1;
+                                    cam_frame_release(frame_pos);
+                                    CAM_STAT_INC(cam_obj, drop_queue_send);
                                     ESP_CAMERA_ETS_PRINTF(DRAM_STR("cam_hal: FBQ-SND\r\n"));
                                 }
                                 //free the popped buffer
+                                CAM_STAT_INC(cam_obj, drop_queue_full);
                                 cam_give(fb2);
                             } else {
                                 //queue is full and we could not pop a frame from it
-                                cam_obj->frames[frame_pos].en = 1;
+                                cam_frame_release(frame_pos);
+                                CAM_STAT_INC(cam_obj, drop_queue_send);
                                 ESP_CAMERA_ETS_PRINTF(DRAM_STR("cam_hal: FBQ-RCV\r\n"));
                             }
                         }
                     }
 
-                    if(!cam_start_frame(&frame_pos)){
+                    if(!cam_start_frame(&frame_pos, &msg)){
                         cam_obj->state = CAM_STATE_IDLE;
                     } else {
                         cam_obj->frames[frame_pos].fb.len = 0;
@@ -429,13 +597,8 @@ static void cam_task(void *arg)
     }
 }
 
-static lldesc_t * allocate_dma_descriptors(uint32_t count, uint16_t size, uint8_t * buffer)
+static void init_dma_descriptors(lldesc_t *dma, uint32_t count, uint16_t size, uint8_t * buffer)
 {
-    lldesc_t *dma = (lldesc_t *)heap_caps_malloc(count * sizeof(lldesc_t), MALLOC_CAP_DMA);
-    if (dma == NULL) {
-        return dma;
-    }
-
     for (int x = 0; x < count; x++) {
         dma[x].size = size;
         dma[x].length = 0;
@@ -445,6 +608,15 @@ static lldesc_t * allocate_dma_descriptors(uint32_t count, uint16_t size, uint8_
         dma[x].buf = (buffer + size * x);
         dma[x].empty = (uint32_t)&dma[(x + 1) % count];
     }
+}
+
+static lldesc_t * allocate_dma_descriptors(uint32_t count, uint16_t size, uint8_t * buffer)
+{
+    lldesc_t *dma = (lldesc_t *)heap_caps_malloc(count * sizeof(lldesc_t), MALLOC_CAP_DMA);
+    if (dma == NULL) {
+        return dma;
+    }
+    init_dma_descriptors(dma, count, size, buffer);
     return dma;
 }
 
@@ -489,10 +661,35 @@ static esp_err_t cam_dma_config(const camera_config_t *config)
     } else {
         _caps |= MALLOC_CAP_SPIRAM;
     }
+    cam_obj->fb_external = config->fb_pool != NULL && !cam_obj->slice_only;
+    cam_obj->fb_cap = cam_obj->slice_only ? UINT32_MAX : fb_size;
     for (int x = 0; x < cam_obj->frame_cnt; x++) {
         cam_obj->frames[x].dma = NULL;
         cam_obj->frames[x].fb_offset = 0;
-        cam_obj->frames[x].en = 0;
+        if (cam_obj->slice_only) {
+            continue;
+        }
+        if (cam_obj->fb_external) {
+            // capture straight into the caller's buffer; only skip ahead as far as the DMA alignment needs
+            uint8_t *buf = config->fb_pool[x];
+            CAM_CHECK(buf != NULL, "fb_pool entry is NULL", ESP_FAIL);
+            size_t offset = dma_align ? (-(uintptr_t)buf) & (dma_align - 1) : 0;
+            if (config->fb_pool_size < fb_size + offset) {
+                ESP_LOGE(TAG, "fb_pool[%d] holds %u bytes, %u needed", x, (unsigned) config->fb_pool_size,
+                         (unsigned) (fb_size + offset));
+                return ESP_FAIL;
+            }
+            cam_obj->frames[x].fb_offset = offset;
+            cam_obj->frames[x].fb.buf = buf + offset;
+            if (config->fb_pool_size - offset < cam_obj->fb_cap) {
+                cam_obj->fb_cap = config->fb_pool_size - offset;
+            }
+            if (cam_obj->psram_mode) {
+                cam_obj->frames[x].dma = allocate_dma_descriptors(cam_obj->dma_node_cnt, cam_obj->dma_node_buffer_size, cam_obj->frames[x].fb.buf);
+                CAM_CHECK(cam_obj->frames[x].dma != NULL, "frame dma malloc failed", ESP_FAIL);
+            }
+            continue;
+        }
         ESP_LOGI(TAG, "Allocating %d Byte frame buffer in %s", alloc_size, _caps & MALLOC_CAP_SPIRAM ? "PSRAM" : "OnBoard RAM");
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0)
         // In IDF v4.2 and earlier, memory returned by heap_caps_aligned_alloc must be freed using heap_caps_aligned_free.
@@ -510,8 +707,8 @@ static esp_err_t cam_dma_config(const camera_config_t *config)
             cam_obj->frames[x].dma = allocate_dma_descriptors(cam_obj->dma_node_cnt, cam_obj->dma_node_buffer_size, cam_obj->frames[x].fb.buf);
             CAM_CHECK(cam_obj->frames[x].dma != NULL, "frame dma malloc failed", ESP_FAIL);
         }
-        cam_obj->frames[x].en = 1;
     }
+    cam_give_all();
 
     if (!cam_obj->psram_mode) {
         cam_obj->dma_buffer = (uint8_t *)heap_caps_malloc(cam_obj->dma_buffer_size * sizeof(uint8_t), MALLOC_CAP_DMA);
@@ -524,10 +721,40 @@ static esp_err_t cam_dma_config(const camera_config_t *config)
         cam_obj->dma = allocate_dma_descriptors(cam_obj->dma_node_cnt, cam_obj->dma_node_buffer_size, cam_obj->dma_buffer);
         CAM_CHECK(cam_obj->dma != NULL, "dma malloc failed", ESP_FAIL);
     }
+    cam_obj->dma_buffer_cap = cam_obj->dma_buffer_size;
+    cam_obj->dma_node_cap = cam_obj->dma_node_cnt;
 
     return ESP_OK;
 }
 
+static void cam_set_frame_geometry(cam_obj_t *cam, const camera_config_t *config, framesize_t frame_size)
+{
+    cam->width = resolution[frame_size].width;
+    // ROI capture: the sensor only outputs roi_height rows, size the DMA and frame buffers to match
+    cam->height = config->roi_height ? config->roi_height : resolution[frame_size].height;
+
+    if(cam->jpeg_mode){
+#ifdef CONFIG_CAMERA_JPEG_MODE_FRAME_SIZE_AUTO
+        cam->recv_size = cam->width * cam->height / 5;
+#else
+        cam->recv_size = CONFIG_CAMERA_JPEG_MODE_FRAME_SIZE;
+#endif
+        cam->fb_size = cam->recv_size;
+    } else {
+        cam->recv_size = cam->width * cam->height * cam->in_bytes_per_pixel;
+    }
+
+    // crop / row skip: the DMA still receives whole lines, cam_task copies out the kept part
+    cam->crop_x = config->crop_width ? config->crop_x : 0;
+    cam->row_step = config->row_step > 1 ? config->row_step : 1;
+    cam->fb_width = config->crop_width ? config->crop_width : cam->width;
+    cam->fb_height = (cam->height + cam->row_step - 1) / cam->row_step;
+    cam->cropped = !cam->jpeg_mode && (cam->fb_width != cam->width || cam->row_step > 1);
+    if (!cam->jpeg_mode) {
+        cam->fb_size = cam->fb_width * cam->fb_height * cam->fb_bytes_per_pixel;
+    }
+}
+
 esp_err_t cam_init(const camera_config_t *config)
 {
     CAM_CHECK(NULL != config, "config pointer is invalid", ESP_ERR_INVALID_ARG);
@@ -568,27 +795,23 @@ esp_err_t cam_config(const camera_config_t *config, framesize_t frame_size, uint
     CAM_CHECK_GOTO(ret == ESP_OK, "ll_cam_set_sample_mode failed", err);
     
     cam_obj->jpeg_mode = config->pixel_format == PIXFORMAT_JPEG;
-#if CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3
-    cam_obj->psram_mode = g_psram_dma_mode;
-#else
-    cam_obj->psram_mode = false;
-#endif
+    cam_obj->psram_mode = cam_psram_mode_wanted();
     ESP_LOGI(TAG, "PSRAM DMA mode %s", cam_obj->psram_mode ? "enabled" : "disabled");
-    cam_obj->frame_cnt = config->fb_count;
-    cam_obj->width = resolution[frame_size].width;
-    cam_obj->height = resolution[frame_size].height;
-
-    if(cam_obj->jpeg_mode){
-#ifdef CONFIG_CAMERA_JPEG_MODE_FRAME_SIZE_AUTO
-        cam_obj->recv_size = cam_obj->width * cam_obj->height / 5;
+#if CONFIG_IDF_TARGET_ESP32S3
+    cam_obj->psram_luma = cam_obj->psram_mode && !cam_obj->jpeg_mode &&
+                          cam_obj->in_bytes_per_pixel != cam_obj->fb_bytes_per_pixel;
 #else
-        cam_obj->recv_size = CONFIG_CAMERA_JPEG_MODE_FRAME_SIZE;
+    cam_obj->psram_luma = false;
 #endif
-        cam_obj->fb_size = cam_obj->recv_size;
-    } else {
-        cam_obj->recv_size = cam_obj->width * cam_obj->height * cam_obj->in_bytes_per_pixel;
-        cam_obj->fb_size = cam_obj->width * cam_obj->height * cam_obj->fb_bytes_per_pixel;
+    cam_obj->frame_cnt = config->fb_count;
+    cam_obj->slice_cb = cam_obj->jpeg_mode || cam_obj->psram_mode ? NULL : config->slice_cb;
+    cam_obj->slice_arg = config->slice_arg;
+    cam_obj->slice_only = cam_obj->slice_cb && config->fb_count == 0;
+    if (cam_obj->slice_only) {
+        // one bookkeeping slot without a buffer keeps the frame state machine unchanged
+        cam_obj->frame_cnt = 1;
     }
+    cam_set_frame_geometry(cam_obj, config, frame_size);
 
     ret = cam_dma_config(config);
     CAM_CHECK_GOTO(ret == ESP_OK, "cam_dma_config failed", err);
@@ -597,8 +820,11 @@ esp_err_t cam_config(const camera_config_t *config, framesize_t frame_size, uint
     if (queue_size == 0) {
         queue_size = 1;
     }
-    cam_obj->event_queue = xQueueCreate(queue_size, sizeof(cam_event_t));
+    cam_obj->event_queue_cap = queue_size;
+    cam_obj->event_queue = xQueueCreate(queue_size, sizeof(cam_event_msg_t));
     CAM_CHECK_GOTO(cam_obj->event_queue != NULL, "event_queue create failed", err);
+    cam_obj->stop_sync = xSemaphoreCreateBinary();
+    CAM_CHECK_GOTO(cam_obj->stop_sync != NULL, "stop_sync create failed", err);
 
     size_t frame_buffer_queue_len = cam_obj->frame_cnt;
     if (config->grab_mode == CAMERA_GRAB_LATEST && cam_obj->frame_cnt > 1) {
@@ -640,6 +866,9 @@ esp_err_t cam_deinit(void)
     if (cam_obj->event_queue) {
         vQueueDelete(cam_obj->event_queue);
     }
+    if (cam_obj->stop_sync) {
+        vSemaphoreDelete(cam_obj->stop_sync);
+    }
     if (cam_obj->frame_buffer_queue) {
         vQueueDelete(cam_obj->frame_buffer_queue);
     }
@@ -654,7 +883,9 @@ esp_err_t cam_deinit(void)
     }
     if (cam_obj->frames) {
         for (int x = 0; x < cam_obj->frame_cnt; x++) {
-            free(cam_obj->frames[x].fb.buf - cam_obj->frames[x].fb_offset);
+            if (!cam_obj->fb_external) {
+                free(cam_obj->frames[x].fb.buf - cam_obj->frames[x].fb_offset);
+            }
             if (cam_obj->frames[x].dma) {
                 free(cam_obj->frames[x].dma);
             }
@@ -667,6 +898,81 @@ esp_err_t cam_deinit(void)
     return ESP_OK;
 }
 
+esp_err_t cam_reconfig(const camera_config_t *config, framesize_t frame_size)
+{
+    if (cam_obj->psram_mode || cam_psram_mode_wanted()) {
+        // every frame buffer has its own descriptor chain sized to the old frame, and switching
+        // PSRAM DMA on needs those chains in the first place: only a full reinit can do either
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // size the new frame on a scratch copy first, nothing changes unless it fits what is allocated
+    cam_obj_t *next = (cam_obj_t *)malloc(sizeof(cam_obj_t));
+    if (next == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(next, cam_obj, sizeof(cam_obj_t));
+    cam_set_frame_geometry(next, config, frame_size);
+    bool fits = ll_cam_dma_sizes(next);
+    if (fits) {
+        next->dma_node_cnt = next->dma_buffer_size / next->dma_node_buffer_size;
+        next->frame_copy_cnt = next->recv_size / next->dma_half_buffer_size;
+        fits = next->dma_buffer_size <= cam_obj->dma_buffer_cap && next->dma_node_cnt <= cam_obj->dma_node_cap
+               && next->fb_size <= cam_obj->fb_cap
+               && (next->dma_half_buffer_cnt > 1 ? next->dma_half_buffer_cnt - 1 : 1) <= cam_obj->event_queue_cap;
+    }
+    if (!fits) {
+        free(next);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    cam_stop();
+    // the sync event queues behind whatever the ISRs sent before the stop; once cam_task has
+    // answered it, nothing else touches the DMA state. No tick-granular polling on this path
+    const cam_event_msg_t sync = { .type = CAM_STOP_SYNC_EVENT };
+    xQueueSend(cam_obj->event_queue, &sync, portMAX_DELAY);
+    xSemaphoreTake(cam_obj->stop_sync, portMAX_DELAY);
+    cam_obj->state = CAM_STATE_IDLE;
+
+    cam_obj->width = next->width;
+    cam_obj->height = next->height;
+    cam_obj->recv_size = next->recv_size;
+    cam_obj->fb_size = next->fb_size;
+    cam_obj->fb_width = next->fb_width;
+    cam_obj->fb_height = next->fb_height;
+    cam_obj->crop_x = next->crop_x;
+    cam_obj->row_step = next->row_step;
+    cam_obj->cropped = next->cropped;
+    cam_obj->dma_buffer_size = next->dma_buffer_size;
+    cam_obj->dma_half_buffer_size = next->dma_half_buffer_size;
+    cam_obj->dma_half_buffer_cnt = next->dma_half_buffer_cnt;
+    cam_obj->dma_node_buffer_size = next->dma_node_buffer_size;
+    cam_obj->dma_node_cnt = next->dma_node_cnt;
+    cam_obj->frame_copy_cnt = next->frame_copy_cnt;
+    free(next);
+    init_dma_descriptors(cam_obj->dma, cam_obj->dma_node_cnt, cam_obj->dma_node_buffer_size, cam_obj->dma_buffer);
+
+    // frames queued at the old size would be handed out with the new width/height
+    camera_fb_t *fb = NULL;
+    while (xQueueReceive(cam_obj->frame_buffer_queue, &fb, 0) == pdTRUE) {
+        cam_give(fb);
+    }
+    xQueueReset(cam_obj->event_queue);
+    return ESP_OK;
+}
+
+void cam_note_reconfig(bool fast, uint32_t us)
+{
+    portENTER_CRITICAL(&g_stats_lock);
+    if (fast) {
+        cam_obj->stats.reconfig_fast++;
+    } else {
+        cam_obj->stats.reconfig_full++;
+    }
+    cam_obj->stats.reconfig_last_us = us;
+    portEXIT_CRITICAL(&g_stats_lock);
+}
+
 void cam_stop(void)
 {
     ll_cam_vsync_intr_enable(cam_obj, false);
@@ -678,6 +984,19 @@ void cam_start(void)
     ll_cam_vsync_intr_enable(cam_obj, true);
 }
 
+static void cam_frame_taken(cam_frame_t *frame)
+{
+    frame->take_us = esp_timer_get_time();
+    uint32_t wait = (uint32_t)(frame->take_us - frame->queued_us);
+    portENTER_CRITICAL(&g_stats_lock);
+    cam_obj->stats.frames_taken++;
+    cam_obj->stats.queue_wait_sum_us += wait;
+    if (wait > cam_obj->stats.queue_wait_max_us) {
+        cam_obj->stats.queue_wait_max_us = wait;
+    }
+    portEXIT_CRITICAL(&g_stats_lock);
+}
+
 camera_fb_t *cam_take(TickType_t timeout)
 {
     camera_fb_t *dma_buffer = NULL;
@@ -692,6 +1011,10 @@ camera_fb_t *cam_take(TickType_t timeout)
     /* throttle repeated NO-EOI warnings */
     static uint16_t warn_eoi_miss_cnt = 0;
 
+    if (cam_obj->slice_only) {
+        return NULL;
+    }
+
     for (;;)
     {
         TickType_t elapsed = xTaskGetTickCount() - start; /* TickType_t is unsigned so rollover is safe */
@@ -756,6 +1079,7 @@ camera_fb_t *cam_take(TickType_t timeout)
                     /* DMA may bypass cache, ensure full frame is visible */
                     cam_drop_psram_cache(dma_buffer->buf, dma_buffer->len);
                 }
+                cam_frame_taken((cam_frame_t *)dma_buffer);
                 return dma_buffer;
             }
 
@@ -763,12 +1087,15 @@ skip_eoi_check:
 
             CAM_WARN_THROTTLE(warn_eoi_miss_cnt,
                               "NO-EOI - JPEG end marker missing");
+            CAM_STAT_INC(cam_obj, drop_no_eoi);
             cam_give(dma_buffer);
             continue; /* wait for another frame */
-        } else if (cam_obj->psram_mode &&
+        } else if (cam_obj->psram_mode && !cam_obj->psram_luma &&
                    cam_obj->in_bytes_per_pixel != cam_obj->fb_bytes_per_pixel) {
             /* currently used only for YUV to GRAYSCALE */
+            cam_drop_psram_cache(dma_buffer->buf, dma_buffer->len);
             dma_buffer->len = ll_cam_memcpy(cam_obj, dma_buffer->buf, dma_buffer->buf, dma_buffer->len);
+            cam_sync_psram_cache(dma_buffer->buf, dma_buffer->len);
         }
 
         if (cam_obj->psram_mode) {
@@ -776,24 +1103,21 @@ skip_eoi_check:
             cam_drop_psram_cache(dma_buffer->buf, dma_buffer->len);
         }
 
+        cam_frame_taken((cam_frame_t *)dma_buffer);
         return dma_buffer;
     }
 }
 
 void cam_give(camera_fb_t *dma_buffer)
 {
-    for (int x = 0; x < cam_obj->frame_cnt; x++) {
-        if (&cam_obj->frames[x].fb == dma_buffer) {
-            cam_obj->frames[x].en = 1;
-            break;
-        }
+    int pos = cam_frame_index(dma_buffer);
+    if (pos >= 0) {
+        cam_frame_release(pos);
     }
 }
 
 void cam_give_all(void) {
-    for (int x = 0; x < cam_obj->frame_cnt; x++) {
-        cam_obj->frames[x].en = 1;
-    }
+    atomic_store(&cam_obj->free_mask, cam_obj->frame_cnt >= 32 ? UINT32_MAX : (1u << cam_obj->frame_cnt) - 1);
 }
 
 bool cam_get_available_frames(void)
@@ -801,6 +1125,32 @@ bool cam_get_available_frames(void)
     return 0 < uxQueueMessagesWaiting(cam_obj->frame_buffer_queue);
 }
 
+bool cam_get_fb_timing(const camera_fb_t *fb, camera_fb_timing_t *out)
+{
+    int pos = cam_frame_index(fb);
+    if (pos < 0) {
+        return false;
+    }
+    out->vsync_us = cam_obj->frames[pos].vsync_us;
+    out->eof_us = cam_obj->frames[pos].eof_us;
+    out->take_us = cam_obj->frames[pos].take_us;
+    return true;
+}
+
+void cam_get_stats(camera_stats_t *out)
+{
+    portENTER_CRITICAL(&g_stats_lock);
+    *out = cam_obj->stats;
+    portEXIT_CRITICAL(&g_stats_lock);
+}
+
+void cam_reset_stats(void)
+{
+    portENTER_CRITICAL(&g_stats_lock);
+    memset(&cam_obj->stats, 0, sizeof(cam_obj->stats));
+    portEXIT_CRITICAL(&g_stats_lock);
+}
+
 void cam_set_psram_mode(bool enable)
 {
     portENTER_CRITICAL(&g_psram_dma_lock);
@@ -812,3 +1162,8 @@ bool cam_get_psram_mode(void)
 {
     return g_psram_dma_mode;
 }
+
+bool cam_psram_mode_active(void)
+{
+    return cam_obj && cam_obj->psram_mode;
+}
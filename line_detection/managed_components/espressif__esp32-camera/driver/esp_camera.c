@@ -18,6 +18,9 @@
 #include "sys/time.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
 #include "esp_system.h"
 #include "nvs_flash.h"
@@ -87,14 +90,25 @@
 static const char *TAG = "camera";
 #endif
 
-typedef struct {
+typedef struct camera_state_t {
     sensor_t sensor;
     camera_fb_t fb;
+    framesize_t max_size;
 } camera_state_t;
 
 static const char *CAMERA_SENSOR_NVS_KEY = "sensor";
 static const char *CAMERA_PIXFORMAT_NVS_KEY = "pixformat";
+#if CONFIG_CAMERA_PROBE_CACHE
+static const char *CAMERA_PROBE_NVS_NAMESPACE = "camera";
+static const char *CAMERA_PROBE_NVS_KEY = "probe";
+#endif
 static camera_state_t *s_state = NULL;
+// id behind the esp_camera_create() handle, 0 while there is none. Handles are ids rather than
+// s_state, so one kept past esp_camera_destroy() never matches a later camera at the same address
+static uintptr_t s_handle_id = 0;
+static uintptr_t s_handle_seq = 0;
+
+static esp_err_t camera_deinit(void);
 static camera_config_t s_saved_config;
 
 #if CONFIG_IDF_TARGET_ESP32S3 // LCD_CAM module of ESP32-S3 will generate xclk
@@ -164,6 +178,94 @@ static const sensor_func_t g_sensors[] = {
 #endif
 };
 
+/**
+ * Run detect of g_sensors[index] at slv_addr and initialize the sensor if it matches
+ */
+static bool camera_detect_sensor(size_t index, uint8_t slv_addr, camera_model_t *out_camera_model)
+{
+    sensor_id_t *id = &s_state->sensor.id;
+    if (!g_sensors[index].detect(slv_addr, id)) {
+        return false;
+    }
+    ESP_LOGI(TAG, "Camera PID=0x%02x VER=0x%02x MIDL=0x%02x MIDH=0x%02x",
+        id->PID, id->VER, id->MIDH, id->MIDL);
+    camera_sensor_info_t *info = esp_camera_sensor_get_info(id);
+    if (NULL == info) {
+        return false;
+    }
+    *out_camera_model = info->model;
+    ESP_LOGI(TAG, "Detected %s camera", info->name);
+    g_sensors[index].init(&s_state->sensor);
+    return true;
+}
+
+#if CONFIG_CAMERA_PROBE_CACHE
+/**
+ * Sensor found by the last full scan. The g_sensors index depends on the enabled sensors,
+ * so a hit also has to report the same PID before it is trusted.
+ */
+typedef struct {
+    uint8_t sensor;
+    uint8_t slv_addr;
+    uint16_t pid;
+} camera_probe_cache_t;
+
+static bool camera_probe_cache_load(camera_probe_cache_t *cache)
+{
+    nvs_handle_t handle;
+    if (nvs_open(CAMERA_PROBE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    size_t size = sizeof(*cache);
+    esp_err_t ret = nvs_get_blob(handle, CAMERA_PROBE_NVS_KEY, cache, &size);
+    nvs_close(handle);
+    return ret == ESP_OK && size == sizeof(*cache);
+}
+
+static void camera_probe_cache_store(const camera_probe_cache_t *cache)
+{
+    camera_probe_cache_t old;
+    if (camera_probe_cache_load(&old) && memcmp(&old, cache, sizeof(old)) == 0) {
+        return;
+    }
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(CAMERA_PROBE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, CAMERA_PROBE_NVS_KEY, cache, sizeof(*cache));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (ret == ESP_ERR_NVS_NOT_INITIALIZED) {
+        ESP_LOGD(TAG, "NVS not initialized, the sensor is not remembered");
+    } else if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Could not remember the detected sensor (%s)", esp_err_to_name(ret));
+    }
+}
+
+static bool camera_probe_cached(uint8_t *out_slv_addr, camera_model_t *out_camera_model)
+{
+    camera_probe_cache_t cache;
+    if (!camera_probe_cache_load(&cache)
+            || cache.sensor >= sizeof(g_sensors) / sizeof(sensor_func_t)
+            || ESP_OK != SCCB_Probe(cache.slv_addr)) {
+        return false;
+    }
+    s_state->sensor.slv_addr = cache.slv_addr;
+    if (!camera_detect_sensor(cache.sensor, cache.slv_addr, out_camera_model)) {
+        return false;
+    }
+    if (s_state->sensor.id.PID != cache.pid) {
+        // the detect accepted a different sensor, let the scan sort it out
+        *out_camera_model = CAMERA_NONE;
+        return false;
+    }
+    *out_slv_addr = cache.slv_addr;
+    return true;
+}
+#endif
+
 static esp_err_t camera_probe(const camera_config_t *config, camera_model_t *out_camera_model)
 {
     esp_err_t ret = ESP_OK;
@@ -204,9 +306,9 @@ static esp_err_t camera_probe(const camera_config_t *config, camera_model_t *out
 
         // carefull, logic is inverted compared to reset pin
         gpio_set_level(config->pin_pwdn, 1);
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        vTaskDelay(CONFIG_CAMERA_PWDN_DELAY_MS / portTICK_PERIOD_MS);
         gpio_set_level(config->pin_pwdn, 0);
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        vTaskDelay(CONFIG_CAMERA_PWDN_DELAY_MS / portTICK_PERIOD_MS);
     }
 
     if (config->pin_reset >= 0) {
@@ -217,16 +319,22 @@ static esp_err_t camera_probe(const camera_config_t *config, camera_model_t *out
         gpio_config(&conf);
 
         gpio_set_level(config->pin_reset, 0);
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        vTaskDelay(CONFIG_CAMERA_RESET_DELAY_MS / portTICK_PERIOD_MS);
         gpio_set_level(config->pin_reset, 1);
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        vTaskDelay(CONFIG_CAMERA_RESET_DELAY_MS / portTICK_PERIOD_MS);
     }
 
     ESP_LOGD(TAG, "Searching for camera address");
-    vTaskDelay(10 / portTICK_PERIOD_MS);
+    vTaskDelay(CONFIG_CAMERA_PROBE_DELAY_MS / portTICK_PERIOD_MS);
 
     int camera_model_id;
     uint8_t slv_addr = 0x0;
+    int64_t probe_start = esp_timer_get_time();
+    s_state->sensor.xclk_freq_hz = config->xclk_freq_hz;
+
+#if CONFIG_CAMERA_PROBE_CACHE
+    bool cached = camera_probe_cached(&slv_addr, out_camera_model);
+#endif
 
     /**
      * This loop probes each known sensor until a supported camera is detected
@@ -239,25 +347,22 @@ static esp_err_t camera_probe(const camera_config_t *config, camera_model_t *out
         }
 
         s_state->sensor.slv_addr = slv_addr;
-        s_state->sensor.xclk_freq_hz = config->xclk_freq_hz;
 
         /**
          * Read sensor ID and then initialize sensor
          * Attention: Some sensors have the same SCCB address. Therefore, several attempts may be made in the detection process
          */
-        sensor_id_t *id = &s_state->sensor.id;
-
         for (size_t i = 0; i < sizeof(g_sensors) / sizeof(sensor_func_t); i++) {
-            if (g_sensors[i].detect(slv_addr, id)) {
-                ESP_LOGI(TAG, "Camera PID=0x%02x VER=0x%02x MIDL=0x%02x MIDH=0x%02x",
-                    id->PID, id->VER, id->MIDH, id->MIDL);
-                camera_sensor_info_t *info = esp_camera_sensor_get_info(id);
-                if (NULL != info) {
-                    *out_camera_model = info->model;
-                    ESP_LOGI(TAG, "Detected %s camera", info->name);
-                    g_sensors[i].init(&s_state->sensor);
-                    break;
-                }
+            if (camera_detect_sensor(i, slv_addr, out_camera_model)) {
+#if CONFIG_CAMERA_PROBE_CACHE
+                camera_probe_cache_t cache = {
+                    .sensor = i,
+                    .slv_addr = slv_addr,
+                    .pid = s_state->sensor.id.PID,
+                };
+                camera_probe_cache_store(&cache);
+#endif
+                break;
             }
         }
     }
@@ -269,11 +374,14 @@ static esp_err_t camera_probe(const camera_config_t *config, camera_model_t *out
     }
 
     ESP_LOGI(TAG, "Detected camera at address=0x%02x", slv_addr);
+#if CONFIG_CAMERA_PROBE_CACHE
+    ESP_LOGI(TAG, "Sensor %s in %u us", cached ? "found at the remembered address" : "found by full scan",
+             (unsigned)(esp_timer_get_time() - probe_start));
+#else
+    ESP_LOGI(TAG, "Sensor found in %u us", (unsigned)(esp_timer_get_time() - probe_start));
+#endif
 
-    ESP_LOGD(TAG, "Doing SW reset of sensor");
-    vTaskDelay(10 / portTICK_PERIOD_MS);
-
-    return s_state->sensor.reset(&s_state->sensor);
+    return ESP_OK;
 err :
     CAMERA_DISABLE_OUT_CLOCK();
     return ret;
@@ -296,6 +404,141 @@ static pixformat_t get_output_data_format(camera_conv_mode_t conv_mode)
 }
 #endif
 
+static esp_err_t camera_check_roi(const camera_config_t *config, framesize_t frame_size)
+{
+    if (!config->roi_height) {
+        return ESP_OK;
+    }
+    if (!s_state->sensor.set_roi) {
+        ESP_LOGE(TAG, "ROI capture is not supported on this sensor");
+        return ESP_ERR_CAMERA_NOT_SUPPORTED;
+    }
+    if (config->roi_y + config->roi_height > resolution[frame_size].height) {
+        ESP_LOGE(TAG, "ROI rows %u..%u exceed the frame height %u", config->roi_y,
+                 config->roi_y + config->roi_height - 1, resolution[frame_size].height);
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t camera_check_crop(const camera_config_t *config, framesize_t frame_size)
+{
+    if (!config->crop_width && config->row_step <= 1) {
+        return ESP_OK;
+    }
+    if (config->pixel_format == PIXFORMAT_JPEG || cam_get_psram_mode()
+#if CONFIG_CAMERA_CONVERTER_ENABLED
+        || config->conv_mode != CONV_DISABLE
+#endif
+       ) {
+        ESP_LOGE(TAG, "Crop and row skip need a raw pixel format, PSRAM DMA mode and the converter off");
+        return ESP_ERR_CAMERA_NOT_SUPPORTED;
+    }
+    if (config->crop_width && ((config->crop_x | config->crop_width) & 3
+                               || config->crop_x + config->crop_width > resolution[frame_size].width)) {
+        ESP_LOGE(TAG, "Crop columns %u..%u must be multiples of 4 inside the frame width %u", config->crop_x,
+                 config->crop_x + config->crop_width - 1, resolution[frame_size].width);
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Reset the detected sensor and program it for the configured frame
+ */
+static esp_err_t camera_load_sensor(const camera_config_t *config, framesize_t frame_size)
+{
+    sensor_t *sensor = &s_state->sensor;
+    pixformat_t pix_format = (pixformat_t) config->pixel_format;
+
+    ESP_LOGD(TAG, "Doing SW reset of sensor");
+    vTaskDelay(CONFIG_CAMERA_PROBE_DELAY_MS / portTICK_PERIOD_MS);
+
+    esp_err_t err = sensor->reset(sensor);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Sensor reset failed with error 0x%x", err);
+        return err;
+    }
+
+    ESP_LOGD(TAG, "Setting frame size to %dx%d", resolution[frame_size].width, resolution[frame_size].height);
+    if (sensor->set_framesize(sensor, frame_size) != 0) {
+        ESP_LOGE(TAG, "Failed to set frame size");
+        return ESP_ERR_CAMERA_FAILED_TO_SET_FRAME_SIZE;
+    }
+    sensor->set_pixformat(sensor, pix_format);
+    if (config->roi_height) {
+        ESP_LOGD(TAG, "Setting ROI to rows %u..%u", config->roi_y, config->roi_y + config->roi_height - 1);
+        if (sensor->set_roi(sensor, config->roi_y, config->roi_height) != 0) {
+            ESP_LOGE(TAG, "Failed to set ROI");
+            return ESP_ERR_CAMERA_FAILED_TO_SET_ROI;
+        }
+    }
+#if CONFIG_CAMERA_CONVERTER_ENABLED
+    if(config->conv_mode) {
+        sensor->pixformat = get_output_data_format(config->conv_mode); // If conversion enabled, change the out data format by conversion mode
+    }
+#endif
+
+    if (sensor->id.PID == OV2640_PID) {
+        sensor->set_gainceiling(sensor, GAINCEILING_2X);
+        sensor->set_bpc(sensor, false);
+        sensor->set_wpc(sensor, true);
+        sensor->set_lenc(sensor, true);
+    }
+
+    if (pix_format == PIXFORMAT_JPEG) {
+        sensor->set_quality(sensor, config->jpeg_quality);
+    }
+    sensor->init_status(sensor);
+    return ESP_OK;
+}
+
+#define CAMERA_LOAD_TASK_STACK 4096
+
+typedef struct {
+    const camera_config_t *config;
+    framesize_t frame_size;
+    esp_err_t err;
+    SemaphoreHandle_t done;
+} camera_load_job_t;
+
+static void camera_load_task(void *arg)
+{
+    camera_load_job_t *job = (camera_load_job_t *)arg;
+    job->err = camera_load_sensor(job->config, job->frame_size);
+    // job lives on the stack of esp_camera_init(), do not touch it after this
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Program the sensor on a task of its own, or right here if that task cannot be created
+ */
+static void camera_load_start(camera_load_job_t *job)
+{
+    job->done = xSemaphoreCreateBinary();
+    if (job->done != NULL && xTaskCreatePinnedToCore(camera_load_task, "cam_load", CAMERA_LOAD_TASK_STACK, job,
+            uxTaskPriorityGet(NULL), NULL, tskNO_AFFINITY) == pdPASS) {
+        return;
+    }
+    if (job->done != NULL) {
+        vSemaphoreDelete(job->done);
+        job->done = NULL;
+    }
+    ESP_LOGW(TAG, "No sensor load task, programming the sensor first");
+    job->err = camera_load_sensor(job->config, job->frame_size);
+}
+
+static esp_err_t camera_load_wait(camera_load_job_t *job)
+{
+    if (job->done != NULL) {
+        xSemaphoreTake(job->done, portMAX_DELAY);
+        vSemaphoreDelete(job->done);
+        job->done = NULL;
+    }
+    return job->err;
+}
+
 esp_err_t esp_camera_init(const camera_config_t *config)
 {
     esp_err_t err;
@@ -322,55 +565,69 @@ esp_err_t esp_camera_init(const camera_config_t *config)
         goto fail;
     }
 
-    if (frame_size > camera_sensor[camera_model].max_size) {
+    s_state->max_size = camera_sensor[camera_model].max_size;
+    if (frame_size > s_state->max_size) {
         ESP_LOGW(TAG, "The frame size exceeds the maximum for this sensor, it will be forced to the maximum possible value");
-        frame_size = camera_sensor[camera_model].max_size;
+        frame_size = s_state->max_size;
     }
 
-    err = cam_config(config, frame_size, s_state->sensor.id.PID);
+    err = camera_check_roi(config, frame_size);
+    if (err == ESP_OK) {
+        err = camera_check_crop(config, frame_size);
+    }
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Camera config failed with error 0x%x", err);
         goto fail;
     }
 
-    s_state->sensor.status.framesize = frame_size;
-    s_state->sensor.pixformat = pix_format;
-
-    ESP_LOGD(TAG, "Setting frame size to %dx%d", resolution[frame_size].width, resolution[frame_size].height);
-    if (s_state->sensor.set_framesize(&s_state->sensor, frame_size) != 0) {
-        ESP_LOGE(TAG, "Failed to set frame size");
-        err = ESP_ERR_CAMERA_FAILED_TO_SET_FRAME_SIZE;
+    if (config->slice_cb && (pix_format == PIXFORMAT_JPEG || cam_get_psram_mode())) {
+        ESP_LOGE(TAG, "Slice callback needs a raw pixel format and PSRAM DMA mode off");
+        err = ESP_ERR_CAMERA_NOT_SUPPORTED;
         goto fail;
     }
-    s_state->sensor.set_pixformat(&s_state->sensor, pix_format);
-#if CONFIG_CAMERA_CONVERTER_ENABLED
-    if(config->conv_mode) {
-        s_state->sensor.pixformat = get_output_data_format(config->conv_mode); // If conversion enabled, change the out data format by conversion mode
+    if (config->fb_count > 32) {
+        ESP_LOGE(TAG, "At most 32 frame buffers are supported");
+        err = ESP_ERR_INVALID_ARG;
+        goto fail;
     }
-#endif
-
-    if (s_state->sensor.id.PID == OV2640_PID) {
-        s_state->sensor.set_gainceiling(&s_state->sensor, GAINCEILING_2X);
-        s_state->sensor.set_bpc(&s_state->sensor, false);
-        s_state->sensor.set_wpc(&s_state->sensor, true);
-        s_state->sensor.set_lenc(&s_state->sensor, true);
+    if (config->fb_count == 0 && !config->slice_cb) {
+        ESP_LOGE(TAG, "fb_count 0 is only valid with a slice callback");
+        err = ESP_ERR_INVALID_ARG;
+        goto fail;
     }
 
-    if (pix_format == PIXFORMAT_JPEG) {
-        s_state->sensor.set_quality(&s_state->sensor, config->jpeg_quality);
+    s_state->sensor.status.framesize = frame_size;
+    s_state->sensor.pixformat = pix_format;
+
+    // the sensor tables go out over SCCB while cam_config allocates the DMA and frame buffers
+    camera_load_job_t load = {
+        .config = config,
+        .frame_size = frame_size,
+    };
+    camera_load_start(&load);
+    err = cam_config(config, frame_size, s_state->sensor.id.PID);
+    esp_err_t load_err = camera_load_wait(&load);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Camera config failed with error 0x%x", err);
+        goto fail;
+    }
+    if (load_err != ESP_OK) {
+        err = load_err;
+        goto fail;
     }
-    s_state->sensor.init_status(&s_state->sensor);
 
     cam_start();
 
+    // esp_timer counts from boot, which is as close to power-on as the chip can tell
+    ESP_LOGI(TAG, "Camera ready %u ms after power-on", (unsigned)(esp_timer_get_time() / 1000));
     return ESP_OK;
 
 fail:
-    esp_camera_deinit();
+    camera_deinit();
     return err;
 }
 
-esp_err_t esp_camera_deinit()
+// esp_camera_deinit() without retiring the handle, a full reconfigure keeps it
+static esp_err_t camera_deinit(void)
 {
     esp_err_t ret = cam_deinit();
     CAMERA_DISABLE_OUT_CLOCK();
@@ -384,23 +641,178 @@ esp_err_t esp_camera_deinit()
     return ret;
 }
 
-#define FB_GET_TIMEOUT (4000 / portTICK_PERIOD_MS)
+esp_err_t esp_camera_deinit()
+{
+    s_handle_id = 0;
+    return camera_deinit();
+}
 
-camera_fb_t *esp_camera_fb_get()
+#define CAMERA_INIT_TASK_STACK 4096
+#define CAMERA_INIT_DONE_BIT BIT0
+
+typedef struct {
+    camera_config_t config;
+    camera_init_cb_t cb;
+    void *arg;
+} camera_init_job_t;
+
+static EventGroupHandle_t s_init_events = NULL;
+static volatile bool s_init_running = false;
+static esp_err_t s_init_result = ESP_OK;
+
+static void camera_init_task(void *arg)
 {
-    if (s_state == NULL) {
-        return NULL;
+    camera_init_job_t *job = (camera_init_job_t *)arg;
+    esp_err_t err = esp_camera_init(&job->config);
+    camera_init_cb_t cb = job->cb;
+    void *cb_arg = job->arg;
+    free(job);
+    // publish the result before the callback, it may wait on it or start the next init
+    s_init_result = err;
+    s_init_running = false;
+    xEventGroupSetBits(s_init_events, CAMERA_INIT_DONE_BIT);
+    if (cb) {
+        cb(err, cb_arg);
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t esp_camera_init_async(const camera_config_t *config, camera_init_cb_t cb, void *arg)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_state != NULL || s_init_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_init_events == NULL) {
+        s_init_events = xEventGroupCreate();
+        if (s_init_events == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    camera_init_job_t *job = (camera_init_job_t *)malloc(sizeof(camera_init_job_t));
+    if (job == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    job->config = *config;
+    job->cb = cb;
+    job->arg = arg;
+
+    xEventGroupClearBits(s_init_events, CAMERA_INIT_DONE_BIT);
+    s_init_running = true;
+    if (xTaskCreatePinnedToCore(camera_init_task, "cam_init", CAMERA_INIT_TASK_STACK, job,
+            uxTaskPriorityGet(NULL), NULL, tskNO_AFFINITY) != pdPASS) {
+        s_init_running = false;
+        free(job);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_camera_init_wait(uint32_t timeout_ms)
+{
+    if (s_init_events == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    TickType_t ticks = timeout_ms == ESP_CAMERA_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    EventBits_t bits = xEventGroupWaitBits(s_init_events, CAMERA_INIT_DONE_BIT, pdFALSE, pdTRUE, ticks);
+    return (bits & CAMERA_INIT_DONE_BIT) ? s_init_result : ESP_ERR_TIMEOUT;
+}
+
+static bool camera_handle_valid(esp_camera_handle_t handle)
+{
+    return handle != NULL && s_state != NULL && (uintptr_t)handle == s_handle_id;
+}
+
+esp_err_t esp_camera_create(const camera_config_t *config, esp_camera_handle_t *out)
+{
+    if (config == NULL || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = NULL;
+    if (s_state != NULL) {
+        // I2S0 on the ESP32, LCD_CAM on the S2/S3: there is one camera interface per chip
+        ESP_LOGE(TAG, "The camera interface is already in use");
+        return ESP_ERR_CAMERA_NOT_SUPPORTED;
+    }
+    esp_err_t err = esp_camera_init(config);
+    if (err == ESP_OK) {
+        if (++s_handle_seq == 0) {
+            s_handle_seq = 1;
+        }
+        s_handle_id = s_handle_seq;
+        *out = (esp_camera_handle_t)s_handle_id;
     }
+    return err;
+}
+
+esp_err_t esp_camera_destroy(esp_camera_handle_t handle)
+{
+    if (!camera_handle_valid(handle)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return esp_camera_deinit();
+}
+
+#define FB_GET_TIMEOUT (4000 / portTICK_PERIOD_MS)
+
+static camera_fb_t *camera_fb_get(void)
+{
     camera_fb_t *fb = cam_take(FB_GET_TIMEOUT);
     //set the frame properties
     if (fb) {
-        fb->width = resolution[s_state->sensor.status.framesize].width;
-        fb->height = resolution[s_state->sensor.status.framesize].height;
         fb->format = s_state->sensor.pixformat;
+        fb->exposure = s_state->sensor.status.aec_value;
+        fb->gain = s_state->sensor.status.agc_gain;
     }
     return fb;
 }
 
+camera_fb_t *esp_camera_handle_fb_get(esp_camera_handle_t handle)
+{
+    if (!camera_handle_valid(handle)) {
+        return NULL;
+    }
+    return camera_fb_get();
+}
+
+void esp_camera_handle_fb_return(esp_camera_handle_t handle, camera_fb_t *fb)
+{
+    if (!camera_handle_valid(handle)) {
+        return;
+    }
+    cam_give(fb);
+}
+
+esp_err_t esp_camera_handle_get_stats(esp_camera_handle_t handle, camera_stats_t *out)
+{
+    if (!camera_handle_valid(handle)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cam_get_stats(out);
+    return ESP_OK;
+}
+
+sensor_t *esp_camera_handle_sensor_get(esp_camera_handle_t handle)
+{
+    if (!camera_handle_valid(handle)) {
+        return NULL;
+    }
+    return &s_state->sensor;
+}
+
+camera_fb_t *esp_camera_fb_get()
+{
+    if (s_state == NULL) {
+        return NULL;
+    }
+    return camera_fb_get();
+}
+
 void esp_camera_fb_return(camera_fb_t *fb)
 {
     if (s_state == NULL) {
@@ -409,6 +821,37 @@ void esp_camera_fb_return(camera_fb_t *fb)
     cam_give(fb);
 }
 
+esp_err_t esp_camera_fb_get_timing(const camera_fb_t *fb, camera_fb_timing_t *out)
+{
+    if (s_state == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (fb == NULL || out == NULL || !cam_get_fb_timing(fb, out)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_camera_get_stats(camera_stats_t *out)
+{
+    if (s_state == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cam_get_stats(out);
+    return ESP_OK;
+}
+
+void esp_camera_reset_stats(void)
+{
+    if (s_state == NULL) {
+        return;
+    }
+    cam_reset_stats();
+}
+
 sensor_t *esp_camera_sensor_get()
 {
     if (s_state == NULL) {
@@ -520,19 +963,99 @@ bool esp_camera_available_frames(void)
     return cam_get_available_frames();
 }
 
+// everything except frame_size, roi_y / roi_height, crop_x / crop_width / row_step and jpeg_quality is the same
+static bool camera_same_setup(const camera_config_t *a, const camera_config_t *b)
+{
+    return a->pin_pwdn == b->pin_pwdn && a->pin_reset == b->pin_reset && a->pin_xclk == b->pin_xclk
+           && a->pin_sccb_sda == b->pin_sccb_sda && a->pin_sccb_scl == b->pin_sccb_scl
+           && a->pin_d7 == b->pin_d7 && a->pin_d6 == b->pin_d6 && a->pin_d5 == b->pin_d5 && a->pin_d4 == b->pin_d4
+           && a->pin_d3 == b->pin_d3 && a->pin_d2 == b->pin_d2 && a->pin_d1 == b->pin_d1 && a->pin_d0 == b->pin_d0
+           && a->pin_vsync == b->pin_vsync && a->pin_href == b->pin_href && a->pin_pclk == b->pin_pclk
+           && a->xclk_freq_hz == b->xclk_freq_hz && a->ledc_timer == b->ledc_timer && a->ledc_channel == b->ledc_channel
+           && a->pixel_format == b->pixel_format && a->fb_count == b->fb_count && a->fb_location == b->fb_location
+           && a->grab_mode == b->grab_mode
+#if CONFIG_CAMERA_CONVERTER_ENABLED
+           && a->conv_mode == b->conv_mode
+#endif
+           && a->sccb_i2c_port == b->sccb_i2c_port && a->slice_cb == b->slice_cb && a->slice_arg == b->slice_arg
+           && a->fb_pool == b->fb_pool && a->fb_pool_size == b->fb_pool_size;
+}
+
+static esp_err_t camera_reconfigure_fast(const camera_config_t *config)
+{
+    framesize_t frame_size = (framesize_t) config->frame_size;
+    if (frame_size > s_state->max_size) {
+        frame_size = s_state->max_size;
+    }
+    esp_err_t err = camera_check_roi(config, frame_size);
+    if (err == ESP_OK) {
+        err = camera_check_crop(config, frame_size);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = cam_reconfig(config, frame_size);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    s_state->sensor.status.framesize = frame_size;
+    if (s_state->sensor.set_framesize(&s_state->sensor, frame_size) != 0) {
+        ESP_LOGE(TAG, "Failed to set frame size");
+        return ESP_ERR_CAMERA_FAILED_TO_SET_FRAME_SIZE;
+    }
+    if (config->roi_height) {
+        if (s_state->sensor.set_roi(&s_state->sensor, config->roi_y, config->roi_height) != 0) {
+            ESP_LOGE(TAG, "Failed to set ROI");
+            return ESP_ERR_CAMERA_FAILED_TO_SET_ROI;
+        }
+    }
+    if (config->pixel_format == PIXFORMAT_JPEG && config->jpeg_quality != s_saved_config.jpeg_quality) {
+        s_state->sensor.set_quality(&s_state->sensor, config->jpeg_quality);
+    }
+    cam_start();
+    return ESP_OK;
+}
+
 esp_err_t esp_camera_reconfigure(const camera_config_t *config)
 {
     if (!config) {
         return ESP_ERR_INVALID_ARG;
     }
+    int64_t t0 = esp_timer_get_time();
+    if (s_state && camera_same_setup(&s_saved_config, config)) {
+        esp_err_t err = camera_reconfigure_fast(config);
+        if (err == ESP_OK) {
+            uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+            s_saved_config = *config;
+            cam_note_reconfig(true, us);
+            ESP_LOGI(TAG, "Reconfigured in place in %u us", (unsigned) us);
+            return ESP_OK;
+        }
+        if (err == ESP_ERR_INVALID_ARG || err == ESP_ERR_CAMERA_NOT_SUPPORTED) {
+            // bad ROI, a full reinit would fail the same way and leave the camera down
+            return err;
+        }
+        // a frame that does not fit leaves the driver untouched; anything later is repaired by the full path
+        ESP_LOGD(TAG, "In-place reconfigure not possible (0x%x), reinitializing", err);
+    }
     if (s_state) {
-        esp_err_t err = esp_camera_deinit();
+        esp_err_t err = camera_deinit();
         if (err != ESP_OK) {
             return err;
         }
     }
     s_saved_config = *config;
-    return esp_camera_init(&s_saved_config);
+    esp_err_t err = esp_camera_init(&s_saved_config);
+    if (err != ESP_OK) {
+        // the camera is gone, its handle must not come back with a later esp_camera_init()
+        s_handle_id = 0;
+    } else {
+        uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+        cam_note_reconfig(false, us);
+        ESP_LOGI(TAG, "Reinitialized in %u us", (unsigned) us);
+    }
+    return err;
 }
 
 esp_err_t esp_camera_set_psram_mode(bool enable)
@@ -541,7 +1064,15 @@ esp_err_t esp_camera_set_psram_mode(bool enable)
     if (!s_state) {
         return ESP_ERR_INVALID_STATE;
     }
-    return esp_camera_reconfigure(&s_saved_config);
+    esp_err_t err = esp_camera_reconfigure(&s_saved_config);
+#if CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3
+    // the config is unchanged, only a full reinit switches the DMA mode; make sure one happened
+    if (err == ESP_OK && cam_psram_mode_active() != enable) {
+        ESP_LOGE(TAG, "PSRAM DMA mode still %s after reconfigure", enable ? "off" : "on");
+        return ESP_ERR_INVALID_STATE;
+    }
+#endif
+    return err;
 }
 
 bool esp_camera_get_psram_mode(void)
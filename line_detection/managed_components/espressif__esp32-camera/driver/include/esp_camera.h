@@ -82,6 +82,27 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Rows of a frame that have just arrived, see camera_config_t::slice_cb
+ */
+typedef struct {
+    const uint8_t *buf;         /*!< Pixel data of the rows, in the frame buffer format */
+    size_t len;                 /*!< Length of the data in bytes */
+    uint16_t width;             /*!< Width of the frame in pixels (crop_width when cropping) */
+    uint16_t height;            /*!< Height of the frame in pixels (roi_height when ROI capture is on, divided by row_step when skipping rows) */
+    uint16_t y;                 /*!< First row of the slice */
+    uint16_t rows;              /*!< Number of rows in the slice, the frame is complete when y + rows == height */
+    uint32_t frame;             /*!< Frame counter, incremented at the end of every frame */
+} camera_slice_t;
+
+/**
+ * @brief Slice callback, called from the camera task
+ *
+ * The data is only valid until the callback returns. The callback delays the next DMA copy,
+ * so it must not block and should be much shorter than one DMA half-buffer of capture time.
+ */
+typedef void (*camera_slice_cb_t)(const camera_slice_t *slice, void *arg);
+
 /**
  * @brief Configuration structure for camera initialization
  */
@@ -147,7 +168,7 @@ typedef struct {
     framesize_t frame_size;         /*!< Size of the output image: FRAMESIZE_ + QVGA|CIF|VGA|SVGA|XGA|SXGA|UXGA  */
 
     int jpeg_quality;               /*!< Quality of JPEG output. 0-63 lower means higher quality  */
-    size_t fb_count;                /*!< Number of frame buffers to be allocated. If more than one, then each frame will be acquired (double speed)  */
+    size_t fb_count;                /*!< Number of frame buffers to be allocated. If more than one, then each frame will be acquired (double speed). 0 with slice_cb set allocates none, frames are only seen through slice_cb  */
     camera_fb_location_t fb_location; /*!< The location where the frame buffer will be allocated */
     camera_grab_mode_t grab_mode;   /*!< When buffers should be filled */
 #if CONFIG_CAMERA_CONVERTER_ENABLED
@@ -155,6 +176,19 @@ typedef struct {
 #endif
 
     int sccb_i2c_port;              /*!< If pin_sccb_sda is -1, use the already configured I2C bus by number */
+
+    uint16_t roi_y;                 /*!< First row of the region of interest, in frame_size coordinates */
+    uint16_t roi_height;            /*!< Rows captured from roi_y on, 0 captures the full frame. Frame buffers and DMA are sized to frame width x roi_height */
+
+    uint16_t crop_x;                /*!< First column kept in the frame buffer, multiple of 4 */
+    uint16_t crop_width;            /*!< Columns kept from crop_x on, multiple of 4; 0 keeps whole lines. The rest of each line is dropped while copying out of the DMA buffer */
+    uint8_t row_step;               /*!< Keep one row out of row_step, 0 or 1 keeps every row. Frame buffers are sized to crop_width x ceil(rows / row_step). Cropping and row skipping need a raw pixel format, PSRAM DMA mode and the converter off */
+
+    camera_slice_cb_t slice_cb;     /*!< Called with every completed DMA half-buffer while the frame is still being captured. Not supported for JPEG or PSRAM DMA mode */
+    void *slice_arg;                /*!< Argument passed to slice_cb */
+
+    uint8_t * const *fb_pool;       /*!< fb_count caller-owned buffers to capture into instead of allocating, fb_location is then ignored. The driver never frees them, they must outlive esp_camera_deinit(). NULL lets the driver allocate */
+    size_t fb_pool_size;            /*!< Size of each fb_pool buffer in bytes. Must hold one frame; in PSRAM DMA mode also one DMA half-buffer plus alignment, and the buffers must be DMA capable */
 } camera_config_t;
 
 /**
@@ -166,14 +200,60 @@ typedef struct {
     size_t width;               /*!< Width of the buffer in pixels */
     size_t height;              /*!< Height of the buffer in pixels */
     pixformat_t format;         /*!< Format of the pixel data */
-    struct timeval timestamp;   /*!< Timestamp since boot of the first DMA buffer of the frame */
+    struct timeval timestamp;   /*!< Timestamp since boot of the VSYNC interrupt that started the frame */
+    uint32_t seq;               /*!< VSYNC count when the frame started. Every VSYNC is counted, so a gap between frames means frames were lost */
+    uint16_t exposure;          /*!< Sensor status aec_value when the frame was handed out. Under AEC this is the last programmed value, not read back from the sensor */
+    uint8_t gain;               /*!< Sensor status agc_gain when the frame was handed out, same caveat as exposure under AGC */
 } camera_fb_t;
 
+/**
+ * @brief Per-frame latency trace points, esp_timer_get_time() microseconds
+ */
+typedef struct {
+    int64_t vsync_us;           /*!< VSYNC interrupt that started the frame */
+    int64_t eof_us;             /*!< Last DMA EOF interrupt of the frame, 0 if EOF interrupts are off (non-JPEG PSRAM DMA) */
+    int64_t take_us;            /*!< Frame handed out by esp_camera_fb_get() */
+} camera_fb_timing_t;
+
+/**
+ * @brief Driver counters, all since esp_camera_init() or esp_camera_reset_stats()
+ */
+typedef struct {
+    uint32_t vsyncs;            /*!< VSYNC interrupts seen */
+    uint32_t frames;            /*!< Frames queued for esp_camera_fb_get() */
+    uint32_t frames_taken;      /*!< Frames handed out by esp_camera_fb_get() */
+    uint32_t drop_no_fb;        /*!< Frames not captured because the app held every frame buffer */
+    uint32_t drop_fb_overflow;  /*!< FB-OVF: more data than the frame buffer holds */
+    uint32_t drop_dma_overflow; /*!< DMA overflow in PSRAM DMA mode */
+    uint32_t drop_size;         /*!< FB-SIZE: raw frame length differs from width x height */
+    uint32_t drop_no_soi;       /*!< JPEG frame without start marker */
+    uint32_t drop_no_eoi;       /*!< JPEG frame without end marker, dropped in esp_camera_fb_get() */
+    uint32_t drop_queue_full;   /*!< Oldest queued frame returned to make room for a newer one */
+    uint32_t drop_queue_send;   /*!< FBQ-SND / FBQ-RCV: frame could not be queued at all */
+    uint32_t event_overflow;    /*!< ISR event queue full, the frame in progress was aborted */
+    uint32_t queue_wait_max_us; /*!< Longest time a frame waited in the queue before esp_camera_fb_get() */
+    uint64_t queue_wait_sum_us; /*!< Sum of the queue waits, divide by frames_taken for the average */
+    uint32_t reconfig_fast;     /*!< esp_camera_reconfigure() calls that reused the existing allocation */
+    uint32_t reconfig_full;     /*!< esp_camera_reconfigure() calls that rebuilt the driver (counters restart there, so 0 or 1) */
+    uint32_t reconfig_last_us;  /*!< Duration of the last esp_camera_reconfigure() */
+} camera_stats_t;
+
 #define ESP_ERR_CAMERA_BASE 0x20000
 #define ESP_ERR_CAMERA_NOT_DETECTED             (ESP_ERR_CAMERA_BASE + 1)
 #define ESP_ERR_CAMERA_FAILED_TO_SET_FRAME_SIZE (ESP_ERR_CAMERA_BASE + 2)
 #define ESP_ERR_CAMERA_FAILED_TO_SET_OUT_FORMAT (ESP_ERR_CAMERA_BASE + 3)
 #define ESP_ERR_CAMERA_NOT_SUPPORTED            (ESP_ERR_CAMERA_BASE + 4)
+#define ESP_ERR_CAMERA_FAILED_TO_SET_ROI        (ESP_ERR_CAMERA_BASE + 5)
+
+/**
+ * @brief Handle of an initialized camera, see esp_camera_create()
+ *
+ * There is one camera interface per chip, so at most one handle is valid at a time. A handle
+ * stays valid across esp_camera_reconfigure() and becomes invalid with esp_camera_destroy() or
+ * esp_camera_deinit(); every esp_camera_handle_*() function rejects it from then on, also
+ * after a new camera has been created. It is an id, never a pointer to dereference.
+ */
+typedef struct esp_camera_handle_s *esp_camera_handle_t;
 
 /**
  * @brief Initialize the camera driver
@@ -181,6 +261,8 @@ typedef struct {
  * This function detects and configures camera over I2C interface,
  * allocates framebuffer and DMA buffers,
  * initializes parallel I2S input, and sets up DMA descriptors.
+ * Once the sensor is detected, its registers are written from a short-lived
+ * task while the buffers are allocated.
  *
  * Currently this function can only be called once and there is
  * no way to de-initialize this module.
@@ -200,10 +282,111 @@ esp_err_t esp_camera_init(const camera_config_t* config);
  */
 esp_err_t esp_camera_deinit(void);
 
+/**
+ * @brief Completion callback of esp_camera_init_async(), called from the init task
+ *
+ * Runs after the init is marked done: esp_camera_init_wait() returns err without blocking,
+ * and the callback may call other camera functions or start another esp_camera_init_async().
+ *
+ * @param err  What esp_camera_init() returned
+ * @param arg  The arg given to esp_camera_init_async()
+ */
+typedef void (*camera_init_cb_t)(esp_err_t err, void *arg);
+
+#define ESP_CAMERA_WAIT_FOREVER UINT32_MAX /*!< esp_camera_init_wait() timeout without a limit */
+
+/**
+ * @brief Initialize the camera driver on a task of its own
+ *
+ * Runs esp_camera_init() in the background so the caller can bring up Wi-Fi or other
+ * peripherals meanwhile. The configuration is copied; memory it points to (fb_pool) has to
+ * stay valid. The end is reported through cb, if given, and through esp_camera_init_wait().
+ * Other camera functions must not be called before then.
+ *
+ * @param config  Camera configuration parameters
+ * @param cb      Called with the result when the init finishes, may be NULL
+ * @param arg     Passed to cb
+ *
+ * @return
+ *      - ESP_OK if the init task was started
+ *      - ESP_ERR_INVALID_ARG if config is NULL
+ *      - ESP_ERR_INVALID_STATE if the camera is initialized or an init is already running
+ *      - ESP_ERR_NO_MEM if the task could not be created
+ */
+esp_err_t esp_camera_init_async(const camera_config_t *config, camera_init_cb_t cb, void *arg);
+
+/**
+ * @brief Wait for the init started by esp_camera_init_async()
+ *
+ * @param timeout_ms  Longest wait, ESP_CAMERA_WAIT_FOREVER for no limit
+ *
+ * @return
+ *      - What esp_camera_init() returned, once the init has finished
+ *      - ESP_ERR_TIMEOUT if it is still running
+ *      - ESP_ERR_INVALID_STATE if esp_camera_init_async() was never called
+ */
+esp_err_t esp_camera_init_wait(uint32_t timeout_ms);
+
+/**
+ * @brief Initialize the camera driver and return a handle to it
+ *
+ * Same as esp_camera_init(). The functions without a handle keep working on the camera
+ * created here. Each chip has a single camera interface (I2S0 on the ESP32, LCD_CAM on the
+ * ESP32-S2/S3), so only one camera, and only one valid handle, can exist at a time.
+ *
+ * @param config  Camera configuration parameters
+ * @param out     Set to the new handle on success, NULL otherwise
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if config or out is NULL
+ *      - ESP_ERR_CAMERA_NOT_SUPPORTED if a camera already exists
+ *      - Propagated error from esp_camera_init()
+ */
+esp_err_t esp_camera_create(const camera_config_t *config, esp_camera_handle_t *out);
+
+/**
+ * @brief Deinitialize a camera created with esp_camera_create()
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if handle is not the current camera, e.g. already destroyed
+ */
+esp_err_t esp_camera_destroy(esp_camera_handle_t handle);
+
+/**
+ * @brief esp_camera_fb_get() for a given camera
+ *
+ * @return pointer to the frame buffer, NULL on timeout, for an invalid handle or when no frame buffers are allocated
+ */
+camera_fb_t *esp_camera_handle_fb_get(esp_camera_handle_t handle);
+
+/**
+ * @brief esp_camera_fb_return() for a given camera, does nothing for an invalid handle
+ */
+void esp_camera_handle_fb_return(esp_camera_handle_t handle, camera_fb_t *fb);
+
+/**
+ * @brief esp_camera_get_stats() for a given camera
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if out is NULL
+ *      - ESP_ERR_INVALID_STATE if handle is not the current camera
+ */
+esp_err_t esp_camera_handle_get_stats(esp_camera_handle_t handle, camera_stats_t *out);
+
+/**
+ * @brief esp_camera_sensor_get() for a given camera
+ *
+ * @return pointer to the sensor, NULL for an invalid handle
+ */
+sensor_t *esp_camera_handle_sensor_get(esp_camera_handle_t handle);
+
 /**
  * @brief Obtain pointer to a frame buffer.
  *
- * @return pointer to the frame buffer
+ * @return pointer to the frame buffer, NULL on timeout or when no frame buffers are allocated (fb_count 0)
  */
 camera_fb_t* esp_camera_fb_get(void);
 
@@ -214,6 +397,38 @@ camera_fb_t* esp_camera_fb_get(void);
  */
 void esp_camera_fb_return(camera_fb_t * fb);
 
+/**
+ * @brief Get the latency trace points of a frame buffer
+ *
+ * Must be called before the frame buffer is returned with esp_camera_fb_return().
+ *
+ * @param fb    Frame buffer obtained from esp_camera_fb_get()
+ * @param out   Filled with the trace points of the frame
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if fb does not belong to the driver
+ *      - ESP_ERR_INVALID_STATE if the driver hasn't been initialized yet
+ */
+esp_err_t esp_camera_fb_get_timing(const camera_fb_t *fb, camera_fb_timing_t *out);
+
+/**
+ * @brief Get the driver counters
+ *
+ * @param out   Filled with a snapshot of the counters
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if out is NULL
+ *      - ESP_ERR_INVALID_STATE if the driver hasn't been initialized yet
+ */
+esp_err_t esp_camera_get_stats(camera_stats_t *out);
+
+/**
+ * @brief Zero the driver counters
+ */
+void esp_camera_reset_stats(void);
+
 /**
  * @brief Get a pointer to the image sensor control structure
  *
@@ -248,10 +463,13 @@ bool esp_camera_available_frames(void);
 /**
  * @brief Enable or disable PSRAM DMA mode at runtime.
  *
+ * Switching the mode always reinitializes the driver, the in-place path of
+ * esp_camera_reconfigure() cannot change it.
+ *
  * @param enable  True to enable PSRAM DMA mode, false to disable it.
  * @return
- * - ESP_OK on success
- * - ESP_ERR_INVALID_STATE if the camera is not initialized
+ * - ESP_OK on success, the driver now runs in the requested mode
+ * - ESP_ERR_INVALID_STATE if the camera is not initialized, or the mode did not take effect
  * - Propagated error from reinitialization on failure
  */
 esp_err_t esp_camera_set_psram_mode(bool enable);
@@ -259,6 +477,17 @@ esp_err_t esp_camera_set_psram_mode(bool enable);
 /**
  * @brief Reinitialize the camera with a new configuration.
  *
+ * Frame size, pixel format, the region of interest (roi_y / roi_height) and the crop
+ * (crop_x / crop_width / row_step) all take effect here, including the DMA descriptor and
+ * frame buffer sizes.
+ *
+ * When only frame_size, roi_y / roi_height, the crop or jpeg_quality change and the new frame fits the
+ * DMA buffer, descriptors and frame buffers already allocated, they are reused: capture is
+ * stopped, the descriptors are rewritten, the sensor is reprogrammed and capture restarts,
+ * without SCCB probing, XCLK or heap churn. Otherwise the driver is deinitialized and
+ * initialized again. The duration and path taken are in esp_camera_get_stats().
+ * To make a later switch to a larger mode fast, initialize with the largest mode first.
+ *
  * @param config  Updated camera configuration structure
  * @return
  * - ESP_OK on success
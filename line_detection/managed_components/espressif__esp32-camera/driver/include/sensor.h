@@ -263,6 +263,7 @@ typedef struct _sensor {
     int  (*set_res_raw)         (sensor_t *sensor, int startX, int startY, int endX, int endY, int offsetX, int offsetY, int totalX, int totalY, int outputX, int outputY, bool scale, bool binning);
     int  (*set_pll)             (sensor_t *sensor, int bypass, int mul, int sys, int root, int pre, int seld5, int pclken, int pclk);
     int  (*set_xclk)            (sensor_t *sensor, int timer, int xclk);
+    int  (*set_roi)             (sensor_t *sensor, int offset_y, int height); // Output only rows [offset_y, offset_y + height) of the current frame size, NULL if unsupported
 } sensor_t;
 
 camera_sensor_info_t *esp_camera_sensor_get_info(sensor_id_t *id);
@@ -47,6 +47,21 @@ esp_err_t cam_init(const camera_config_t *config);
 
 esp_err_t cam_config(const camera_config_t *config, framesize_t frame_size, uint16_t sensor_pid);
 
+/**
+ * @brief Switch frame size / ROI in place, reusing the DMA buffer, descriptors, frame buffers and queues
+ *
+ * Capture is left stopped on success, call cam_start() once the sensor is reprogrammed.
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_SIZE The new frame needs more than is allocated, nothing was changed
+ *     - ESP_ERR_NOT_SUPPORTED PSRAM DMA mode, nothing was changed
+ *     - ESP_ERR_NO_MEM Scratch allocation failed, nothing was changed
+ */
+esp_err_t cam_reconfig(const camera_config_t *config, framesize_t frame_size);
+
+void cam_note_reconfig(bool fast, uint32_t us);
+
 void cam_stop(void);
 
 void cam_start(void);
@@ -59,8 +74,15 @@ void cam_give_all(void);
 
 bool cam_get_available_frames(void);
 
+bool cam_get_fb_timing(const camera_fb_t *fb, camera_fb_timing_t *out);
+
+void cam_get_stats(camera_stats_t *out);
+void cam_reset_stats(void);
+
 void cam_set_psram_mode(bool enable);
 bool cam_get_psram_mode(void);
+// mode the running driver was configured with, cam_get_psram_mode() is only the request
+bool cam_psram_mode_active(void);
 
 #ifdef __cplusplus
 }
@@ -45,9 +45,88 @@ static int read_reg(uint8_t slv_addr, const uint16_t reg)
     return ret;
 }
 
+/*
+ * Register shadow of the window, subsample and output format registers, per page.
+ * set_framesize() writes all of them on every call; with the shadow only the ones whose value
+ * changes go on the bus, and set_reg_bits() on them needs no read. RESET_RELATED is tracked
+ * for the page, a write with the soft reset bit is always sent and clears the shadow.
+ */
+static int reg_page_sel = -1;    // last value written to RESET_RELATED, -1 when unknown
+static uint8_t reg_shadow[2][256];
+static uint32_t reg_shadow_valid[2][256 / 32];
+
+// registers actually sent to the sensor, set_framesize() logs how many a switch took
+static uint32_t reg_write_cnt = 0;
+
+static void shadow_reset(void)
+{
+    memset(reg_shadow_valid, 0, sizeof(reg_shadow_valid));
+}
+
+static bool shadow_kept(int page, uint16_t reg)
+{
+    if (page == 0) {
+        return (reg >= 0x05 && reg <= 0x0c) || reg == 0x24 || (reg >= 0xf7 && reg <= 0xfa);
+    }
+    return page == 1 && reg >= 0x53 && reg <= 0x59;
+}
+
+static bool shadow_get(uint16_t reg, uint8_t *value)
+{
+    if (reg == RESET_RELATED) {
+        if (reg_page_sel < 0 || (reg_page_sel & 0x80)) {
+            return false;
+        }
+        *value = reg_page_sel;
+        return true;
+    }
+    int page = reg_page_sel < 0 ? -1 : (reg_page_sel & 0x01);
+    if (!shadow_kept(page, reg) || !(reg_shadow_valid[page][reg >> 5] & (1u << (reg & 31)))) {
+        return false;
+    }
+    *value = reg_shadow[page][reg];
+    return true;
+}
+
+static void shadow_update(uint16_t reg, uint8_t value, bool written)
+{
+    if (reg == RESET_RELATED) {
+        if (written && (value & 0x80)) {
+            // soft reset, every register is back at its default
+            shadow_reset();
+        }
+        reg_page_sel = written ? value : -1;
+        return;
+    }
+    int page = reg_page_sel < 0 ? -1 : (reg_page_sel & 0x01);
+    if (!shadow_kept(page, reg)) {
+        return;
+    }
+    if (written) {
+        reg_shadow[page][reg] = value;
+        reg_shadow_valid[page][reg >> 5] |= 1u << (reg & 31);
+    } else {
+        reg_shadow_valid[page][reg >> 5] &= ~(1u << (reg & 31));
+    }
+}
+
+// shadowed value when there is one, otherwise read from the sensor
+static int read_reg_shadow(uint8_t slv_addr, const uint16_t reg)
+{
+    uint8_t value;
+    if (shadow_get(reg, &value)) {
+        return value;
+    }
+    return read_reg(slv_addr, reg);
+}
+
 static int write_reg(uint8_t slv_addr, const uint16_t reg, uint8_t value)
 {
     int ret = 0;
+    uint8_t old_value;
+    if (shadow_get(reg, &old_value) && old_value == value) {
+        return 0;
+    }
 #ifndef REG_DEBUG_ON
     ret = SCCB_Write(slv_addr, reg, value);
 #else
@@ -66,6 +145,8 @@ static int write_reg(uint8_t slv_addr, const uint16_t reg, uint8_t value)
         ESP_LOGE(TAG, "WRITE REG 0x%04x FAILED: %d", reg, ret);
     }
 #endif
+    reg_write_cnt++;
+    shadow_update(reg, value, ret == 0);
     return ret;
 }
 
@@ -78,7 +159,7 @@ static int set_reg_bits(uint8_t slv_addr, uint16_t reg, uint8_t offset, uint8_t
 {
     int ret = 0;
     uint8_t c_value, new_value;
-    ret = read_reg(slv_addr, reg);
+    ret = read_reg_shadow(slv_addr, reg);
     if (ret < 0) {
         return ret;
     }
@@ -180,6 +261,7 @@ static int set_pixformat(sensor_t *sensor, pixformat_t pixformat)
 static int set_framesize(sensor_t *sensor, framesize_t framesize)
 {
     int ret = 0;
+    uint32_t writes = reg_write_cnt;
     if (framesize > FRAMESIZE_VGA) {
         ESP_LOGW(TAG, "Invalid framesize: %u", framesize);
         framesize = FRAMESIZE_VGA;
@@ -272,7 +354,7 @@ static int set_framesize(sensor_t *sensor, framesize_t framesize)
 
 #endif
     if (ret == 0) {
-        ESP_LOGD(TAG, "Set framesize to: %ux%u", w, h);
+        ESP_LOGD(TAG, "Set framesize to: %ux%u, %u registers written", w, h, (unsigned)(reg_write_cnt - writes));
     }
     return 0;
 }
@@ -428,6 +510,9 @@ int gc0308_detect(int slv_addr, sensor_id_t *id)
 
 int gc0308_init(sensor_t *sensor)
 {
+    // the sensor may have been powered down since the last init
+    reg_page_sel = -1;
+    shadow_reset();
     sensor->init_status = init_status;
     sensor->reset = reset;
     sensor->set_pixformat = set_pixformat;
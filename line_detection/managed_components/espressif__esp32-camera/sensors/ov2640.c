@@ -25,54 +25,144 @@ static const char* TAG = "ov2640";
 #endif
 
 static volatile ov2640_bank_t reg_bank = BANK_MAX;
+
+/*
+ * Register shadow: the last value successfully written to each register of both banks. The
+ * init tables fill it, so a bitfield update afterwards is a single write and a write of the
+ * value a register already holds is dropped. SCCB_Read() cannot report a failed read, so
+ * read values are never shadowed. The exposure and gain registers are rewritten by
+ * the sensor while AEC/AGC run, so they are only shadowed while that control is off.
+ */
+static uint8_t reg_shadow[BANK_MAX][256];
+static uint32_t reg_shadow_valid[BANK_MAX][256 / 32];
+
+static void shadow_reset(void)
+{
+    memset(reg_shadow_valid, 0, sizeof(reg_shadow_valid));
+}
+
+static bool shadow_valid(ov2640_bank_t bank, uint8_t reg)
+{
+    return reg_shadow_valid[bank][reg >> 5] & (1u << (reg & 31));
+}
+
+static void shadow_drop(ov2640_bank_t bank, uint8_t reg)
+{
+    reg_shadow_valid[bank][reg >> 5] &= ~(1u << (reg & 31));
+}
+
+static bool shadow_volatile(ov2640_bank_t bank, uint8_t reg)
+{
+    uint8_t auto_en;
+    if (bank != BANK_SENSOR) {
+        return false;
+    }
+    switch (reg) {
+    case GAIN:
+        auto_en = COM8_AGC_EN;
+        break;
+    case REG04:
+    case AEC:
+    case REG45:
+        auto_en = COM8_AEC_EN;
+        break;
+    default:
+        return false;
+    }
+    // until COM8 is known assume AEC/AGC are running
+    return !shadow_valid(BANK_SENSOR, COM8) || (reg_shadow[BANK_SENSOR][COM8] & auto_en);
+}
+
+static void shadow_store(ov2640_bank_t bank, uint8_t reg, uint8_t value)
+{
+    if (bank >= BANK_MAX || shadow_volatile(bank, reg)) {
+        return;
+    }
+    reg_shadow[bank][reg] = value;
+    reg_shadow_valid[bank][reg >> 5] |= 1u << (reg & 31);
+    if (bank == BANK_SENSOR && reg == COM8) {
+        // whatever AEC/AGC left in these while they ran was not seen
+        shadow_drop(BANK_SENSOR, GAIN);
+        shadow_drop(BANK_SENSOR, REG04);
+        shadow_drop(BANK_SENSOR, AEC);
+        shadow_drop(BANK_SENSOR, REG45);
+    }
+}
+
+// RESET and R_BYPASS are pulsed by the mode tables, writing them changes no setting
+static bool is_pulse_reg(ov2640_bank_t bank, uint8_t reg)
+{
+    return bank == BANK_DSP && (reg == RESET || reg == R_BYPASS);
+}
+
+static bool shadow_get(ov2640_bank_t bank, uint8_t reg, uint8_t *value)
+{
+    if (!shadow_valid(bank, reg) || shadow_volatile(bank, reg) || is_pulse_reg(bank, reg)) {
+        return false;
+    }
+    *value = reg_shadow[bank][reg];
+    return true;
+}
+
 static int set_bank(sensor_t *sensor, ov2640_bank_t bank)
 {
     int res = 0;
     if (bank != reg_bank) {
         reg_bank = bank;
         res = SCCB_Write(sensor->slv_addr, BANK_SEL, bank);
+        if (res) {
+            reg_bank = BANK_MAX;
+        }
     }
     return res;
 }
 
+// registers actually sent to the sensor, lets callers see whether a table changed anything
+static uint32_t reg_write_cnt = 0;
+
+/*
+ * The mode tables are applied as a delta: entries whose register already holds the value
+ * are dropped. RESET and R_BYPASS are never found in the shadow, so those pulses are
+ * always sent.
+ */
 static int write_regs(sensor_t *sensor, const uint8_t (*regs)[2])
 {
-    int i=0, res = 0;
-    while (regs[i][0]) {
+    int i = 0, res = 0;
+    while (!res && regs[i][0]) {
+        uint8_t old_value;
         if (regs[i][0] == BANK_SEL) {
             res = set_bank(sensor, regs[i][1]);
-        } else {
+        } else if (reg_bank >= BANK_MAX || !shadow_get(reg_bank, regs[i][0], &old_value) || old_value != regs[i][1]) {
             res = SCCB_Write(sensor->slv_addr, regs[i][0], regs[i][1]);
-        }
-        if (res) {
-            return res;
+            reg_write_cnt++;
+            if (!res) {
+                shadow_store(reg_bank, regs[i][0], regs[i][1]);
+            }
         }
         i++;
     }
+    if (res) {
+        shadow_reset();
+    }
     return res;
 }
 
 static int write_reg(sensor_t *sensor, ov2640_bank_t bank, uint8_t reg, uint8_t value)
 {
+    uint8_t old_value;
+    if (shadow_get(bank, reg, &old_value) && old_value == value) {
+        return 0;
+    }
     int ret = set_bank(sensor, bank);
     if(!ret) {
         ret = SCCB_Write(sensor->slv_addr, reg, value);
+        reg_write_cnt++;
     }
-    return ret;
-}
-
-static int set_reg_bits(sensor_t *sensor, uint8_t bank, uint8_t reg, uint8_t offset, uint8_t mask, uint8_t value)
-{
-    int ret = 0;
-    uint8_t c_value, new_value;
-
-    ret = set_bank(sensor, bank);
-    if(ret) {
-        return ret;
+    if (ret) {
+        shadow_drop(bank, reg);
+    } else {
+        shadow_store(bank, reg, value);
     }
-    c_value = SCCB_Read(sensor->slv_addr, reg);
-    new_value = (c_value & ~(mask << offset)) | ((value & mask) << offset);
-    ret = SCCB_Write(sensor->slv_addr, reg, new_value);
     return ret;
 }
 
@@ -84,6 +174,45 @@ static int read_reg(sensor_t *sensor, ov2640_bank_t bank, uint8_t reg)
     return SCCB_Read(sensor->slv_addr, reg);
 }
 
+// shadowed value when there is one, otherwise read from the sensor
+static int read_reg_shadow(sensor_t *sensor, ov2640_bank_t bank, uint8_t reg)
+{
+    uint8_t value;
+    if (shadow_get(bank, reg, &value)) {
+        return value;
+    }
+    return read_reg(sensor, bank, reg);
+}
+
+static bool reg_changed(ov2640_bank_t bank, uint8_t reg, uint8_t value)
+{
+    uint8_t old_value;
+    return !shadow_get(bank, reg, &old_value) || old_value != value;
+}
+
+// whether writing regs would change any setting, the pulses aside
+static bool regs_changed(const uint8_t (*regs)[2])
+{
+    ov2640_bank_t bank = reg_bank;
+    for (int i = 0; regs[i][0]; i++) {
+        if (regs[i][0] == BANK_SEL) {
+            bank = (ov2640_bank_t)regs[i][1];
+        } else if (bank >= BANK_MAX) {
+            return true;
+        } else if (!is_pulse_reg(bank, regs[i][0]) && reg_changed(bank, regs[i][0], regs[i][1])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int set_reg_bits(sensor_t *sensor, uint8_t bank, uint8_t reg, uint8_t offset, uint8_t mask, uint8_t value)
+{
+    int c_value = read_reg_shadow(sensor, bank, reg);
+    uint8_t new_value = (c_value & ~(mask << offset)) | ((value & mask) << offset);
+    return write_reg(sensor, bank, reg, new_value);
+}
+
 static uint8_t get_reg_bits(sensor_t *sensor, uint8_t bank, uint8_t reg, uint8_t offset, uint8_t mask)
 {
     return (read_reg(sensor, bank, reg) >> offset) & mask;
@@ -102,31 +231,40 @@ static int reset(sensor_t *sensor)
 {
     int ret = 0;
     WRITE_REG_OR_RETURN(BANK_SENSOR, COM7, COM7_SRST);
+    // every register is back at its default, and SRST itself clears
+    shadow_reset();
     vTaskDelay(10 / portTICK_PERIOD_MS);
     WRITE_REGS_OR_RETURN(ov2640_settings_cif);
     return ret;
 }
 
-static int set_pixformat(sensor_t *sensor, pixformat_t pixformat)
+/*
+ * Write the format table, followed by the settle time. Unless forced, nothing is written when
+ * the table would change no setting; after a window change the table has to go out anyway.
+ */
+static int write_pixformat(sensor_t *sensor, pixformat_t pixformat, bool force)
 {
-    int ret = 0;
+    const uint8_t (*regs)[2];
     sensor->pixformat = pixformat;
     switch (pixformat) {
     case PIXFORMAT_RGB565:
     case PIXFORMAT_RGB888:
-        WRITE_REGS_OR_RETURN(ov2640_settings_rgb565);
+        regs = ov2640_settings_rgb565;
         break;
     case PIXFORMAT_YUV422:
     case PIXFORMAT_GRAYSCALE:
-        WRITE_REGS_OR_RETURN(ov2640_settings_yuv422);
+        regs = ov2640_settings_yuv422;
         break;
     case PIXFORMAT_JPEG:
-        WRITE_REGS_OR_RETURN(ov2640_settings_jpeg3);
+        regs = ov2640_settings_jpeg3;
         break;
     default:
-        ret = -1;
-        break;
+        return -1;
     }
+    if (!force && !regs_changed(regs)) {
+        return 0;
+    }
+    int ret = write_regs(sensor, regs);
     if(!ret) {
         vTaskDelay(10 / portTICK_PERIOD_MS);
     }
@@ -134,6 +272,11 @@ static int set_pixformat(sensor_t *sensor, pixformat_t pixformat)
     return ret;
 }
 
+static int set_pixformat(sensor_t *sensor, pixformat_t pixformat)
+{
+    return write_pixformat(sensor, pixformat, false);
+}
+
 static int set_window(sensor_t *sensor, ov2640_sensor_mode_t mode, int offset_x, int offset_y, int max_x, int max_y, int w, int h){
     int ret = 0;
     const uint8_t (*regs)[2];
@@ -194,55 +337,91 @@ static int set_window(sensor_t *sensor, ov2640_sensor_mode_t mode, int offset_x,
         regs = ov2640_settings_to_uxga;
     }
 
-    WRITE_REG_OR_RETURN(BANK_DSP, R_BYPASS, R_BYPASS_DSP_BYPAS);
-    WRITE_REGS_OR_RETURN(regs);
-    WRITE_REGS_OR_RETURN(win_regs);
-    WRITE_REG_OR_RETURN(BANK_SENSOR, CLKRC, c.clk);
-    WRITE_REG_OR_RETURN(BANK_DSP, R_DVP_SP, c.pclk);
-    WRITE_REG_OR_RETURN(BANK_DSP, R_BYPASS, R_BYPASS_DSP_EN);
-
-    vTaskDelay(10 / portTICK_PERIOD_MS);
+    // re-applying the current window touches nothing, not even the bypass and reset pulses
+    bool changed = regs_changed(regs) || regs_changed((const uint8_t (*)[2])win_regs)
+                   || reg_changed(BANK_SENSOR, CLKRC, c.clk) || reg_changed(BANK_DSP, R_DVP_SP, c.pclk);
+    uint32_t writes = reg_write_cnt;
+    if (changed) {
+        WRITE_REG_OR_RETURN(BANK_DSP, R_BYPASS, R_BYPASS_DSP_BYPAS);
+        WRITE_REGS_OR_RETURN(regs);
+        WRITE_REGS_OR_RETURN(win_regs);
+        WRITE_REG_OR_RETURN(BANK_SENSOR, CLKRC, c.clk);
+        WRITE_REG_OR_RETURN(BANK_DSP, R_DVP_SP, c.pclk);
+        WRITE_REG_OR_RETURN(BANK_DSP, R_BYPASS, R_BYPASS_DSP_EN);
+        vTaskDelay(10 / portTICK_PERIOD_MS);
+    }
     //required when changing resolution
-    set_pixformat(sensor, sensor->pixformat);
+    write_pixformat(sensor, sensor->pixformat, changed);
+    ESP_LOGD(TAG, "Mode switch wrote %u registers", (unsigned)(reg_write_cnt - writes));
 
     return ret;
 }
 
+static void get_window(framesize_t framesize, ov2640_sensor_mode_t *mode, uint16_t *offset_x, uint16_t *offset_y, uint16_t *max_x, uint16_t *max_y)
+{
+    aspect_ratio_t ratio = resolution[framesize].aspect_ratio;
+    *max_x = ratio_table[ratio].max_x;
+    *max_y = ratio_table[ratio].max_y;
+    *offset_x = ratio_table[ratio].offset_x;
+    *offset_y = ratio_table[ratio].offset_y;
+    *mode = OV2640_MODE_UXGA;
+
+    if (framesize <= FRAMESIZE_CIF) {
+        *mode = OV2640_MODE_CIF;
+        *max_x /= 4;
+        *max_y /= 4;
+        *offset_x /= 4;
+        *offset_y /= 4;
+        if(*max_y > 296){
+            *max_y = 296;
+        }
+    } else if (framesize <= FRAMESIZE_SVGA) {
+        *mode = OV2640_MODE_SVGA;
+        *max_x /= 2;
+        *max_y /= 2;
+        *offset_x /= 2;
+        *offset_y /= 2;
+    }
+}
+
 static int set_framesize(sensor_t *sensor, framesize_t framesize)
 {
     int ret = 0;
     uint16_t w = resolution[framesize].width;
     uint16_t h = resolution[framesize].height;
-    aspect_ratio_t ratio = resolution[framesize].aspect_ratio;
-    uint16_t max_x = ratio_table[ratio].max_x;
-    uint16_t max_y = ratio_table[ratio].max_y;
-    uint16_t offset_x = ratio_table[ratio].offset_x;
-    uint16_t offset_y = ratio_table[ratio].offset_y;
-    ov2640_sensor_mode_t mode = OV2640_MODE_UXGA;
+    uint16_t max_x, max_y, offset_x, offset_y;
+    ov2640_sensor_mode_t mode;
 
     sensor->status.framesize = framesize;
+    get_window(framesize, &mode, &offset_x, &offset_y, &max_x, &max_y);
 
+    ret = set_window(sensor, mode, offset_x, offset_y, max_x, max_y, w, h);
+    return ret;
+}
 
+/*
+ * Crop the DSP input window to the rows that scale to [offset_y, offset_y + height)
+ * of the current frame size. The sensor still reads the full window, so this trims
+ * the bytes per frame but not the frame period.
+ */
+static int set_roi(sensor_t *sensor, int offset_y, int height)
+{
+    framesize_t framesize = sensor->status.framesize;
+    uint16_t w = resolution[framesize].width;
+    uint16_t h = resolution[framesize].height;
+    uint16_t max_x, max_y, offset_x, win_y;
+    ov2640_sensor_mode_t mode;
 
-    if (framesize <= FRAMESIZE_CIF) {
-        mode = OV2640_MODE_CIF;
-        max_x /= 4;
-        max_y /= 4;
-        offset_x /= 4;
-        offset_y /= 4;
-        if(max_y > 296){
-            max_y = 296;
-        }
-    } else if (framesize <= FRAMESIZE_SVGA) {
-        mode = OV2640_MODE_SVGA;
-        max_x /= 2;
-        max_y /= 2;
-        offset_x /= 2;
-        offset_y /= 2;
+    // ZMOH and VSIZE are programmed in units of 4 lines
+    if (height <= 0 || (height % 4) || offset_y < 0 || offset_y + height > h) {
+        ESP_LOGE(TAG, "Invalid ROI: y=%d h=%d", offset_y, height);
+        return -1;
     }
+    get_window(framesize, &mode, &offset_x, &win_y, &max_x, &max_y);
 
-    ret = set_window(sensor, mode, offset_x, offset_y, max_x, max_y, w, h);
-    return ret;
+    int roi_max_y = (height * max_y / h) & ~3;
+    int roi_win_y = win_y + offset_y * max_y / h;
+    return set_window(sensor, mode, offset_x, roi_win_y, max_x, roi_max_y, w, height);
 }
 
 static int set_contrast(sensor_t *sensor, int level)
@@ -476,7 +655,7 @@ static int get_reg(sensor_t *sensor, int reg, int mask)
 static int set_reg(sensor_t *sensor, int reg, int mask, int value)
 {
     int ret = 0;
-    ret = read_reg(sensor, (reg >> 8) & 0x01, reg & 0xFF);
+    ret = read_reg_shadow(sensor, (reg >> 8) & 0x01, reg & 0xFF);
     if(ret < 0){
         return ret;
     }
@@ -565,6 +744,9 @@ int ov2640_detect(int slv_addr, sensor_id_t *id)
 
 int ov2640_init(sensor_t *sensor)
 {
+    // the sensor may have been powered down since the last init
+    reg_bank = BANK_MAX;
+    shadow_reset();
     sensor->reset = reset;
     sensor->init_status = init_status;
     sensor->set_pixformat = set_pixformat;
@@ -605,6 +787,7 @@ int ov2640_init(sensor_t *sensor)
     sensor->get_reg = get_reg;
     sensor->set_reg = set_reg;
     sensor->set_res_raw = set_res_raw;
+    sensor->set_roi = set_roi;
     sensor->set_pll = _set_pll;
     sensor->set_xclk = set_xclk;
     ESP_LOGD(TAG, "OV2640 Attached");
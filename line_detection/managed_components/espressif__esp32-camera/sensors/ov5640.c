@@ -105,8 +105,95 @@ static int read_reg16(uint8_t slv_addr, const uint16_t reg){
 ////    dump_range(sensor, "AFC control", 0x6000, 0x603F);
 //}
 
+/*
+ * Register shadow of what a mode switch writes: window and timing, PLL and output format.
+ * set_framesize() and set_pixformat() write all of these on every call; with the shadow only
+ * the ones whose value changes go on the bus. The 16 bit register space is too big to shadow
+ * whole, and the AEC/AGC/AWB registers are rewritten by the sensor itself, so only the ranges
+ * below are kept.
+ */
+typedef struct {
+    uint16_t first;
+    uint8_t count;
+} shadow_range_t;
+
+static const shadow_range_t shadow_ranges[] = {
+    {0x3002, 1}, {0x3006, 1},               // JPEG block reset and clock enable
+    {0x3034, 4}, {0x3039, 1},               // PLL
+    {0x3103, 1}, {0x3108, 1},               // system clock source, PCLK root divider
+    {X_ADDR_ST_H, 0x16},                    // window, output size, HTS/VTS, ISP offset, increments
+    {TIMING_TC_REG20, 2}, {0x3824, 1},      // binning, flip, mirror, PCLK divider
+    {FORMAT_CTRL00, 1}, {0x4514, 1}, {0x4520, 1}, {0x460C, 1}, {0x471C, 1},
+    {ISP_CONTROL_01, 1}, {FORMAT_CTRL, 1},
+};
+
+#define SHADOW_SIZE 41 // sum of the counts above
+
+static uint8_t reg_shadow[SHADOW_SIZE];
+static uint64_t reg_shadow_valid;
+
+// registers actually sent to the sensor, set_framesize() logs how many a switch took
+static uint32_t reg_write_cnt = 0;
+
+static int shadow_index(uint16_t reg)
+{
+    int base = 0;
+    for (size_t i = 0; i < sizeof(shadow_ranges) / sizeof(shadow_ranges[0]); i++) {
+        if (reg >= shadow_ranges[i].first && reg < shadow_ranges[i].first + shadow_ranges[i].count) {
+            return base + reg - shadow_ranges[i].first;
+        }
+        base += shadow_ranges[i].count;
+    }
+    return -1;
+}
+
+static bool shadow_get(uint16_t reg, uint8_t *value)
+{
+    int i = shadow_index(reg);
+    if (i < 0 || !(reg_shadow_valid & (1ULL << i))) {
+        return false;
+    }
+    *value = reg_shadow[i];
+    return true;
+}
+
+static void shadow_update(uint16_t reg, uint8_t value, bool written)
+{
+    if (reg == SYSTEM_CTROL0 && (value & 0x80)) {
+        // software reset, every register is back at its default
+        if (written) {
+            reg_shadow_valid = 0;
+        }
+        return;
+    }
+    int i = shadow_index(reg);
+    if (i < 0) {
+        return;
+    }
+    if (written) {
+        reg_shadow[i] = value;
+        reg_shadow_valid |= 1ULL << i;
+    } else {
+        reg_shadow_valid &= ~(1ULL << i);
+    }
+}
+
+// shadowed value when there is one, otherwise read from the sensor
+static int read_reg_shadow(uint8_t slv_addr, const uint16_t reg)
+{
+    uint8_t value;
+    if (shadow_get(reg, &value)) {
+        return value;
+    }
+    return read_reg(slv_addr, reg);
+}
+
 static int write_reg(uint8_t slv_addr, const uint16_t reg, uint8_t value){
     int ret = 0;
+    uint8_t old_value;
+    if (shadow_get(reg, &old_value) && old_value == value) {
+        return 0;
+    }
 #ifndef REG_DEBUG_ON
     ret = SCCB_Write16(slv_addr, reg, value);
 #else
@@ -125,6 +212,8 @@ static int write_reg(uint8_t slv_addr, const uint16_t reg, uint8_t value){
         ESP_LOGE(TAG, "WRITE REG 0x%04x FAILED: %d", reg, ret);
     }
 #endif
+    reg_write_cnt++;
+    shadow_update(reg, value, ret == 0);
     return ret;
 }
 
@@ -132,7 +221,7 @@ static int set_reg_bits(uint8_t slv_addr, uint16_t reg, uint8_t offset, uint8_t
 {
     int ret = 0;
     uint8_t c_value, new_value;
-    ret = read_reg(slv_addr, reg);
+    ret = read_reg_shadow(slv_addr, reg);
     if(ret < 0) {
         return ret;
     }
@@ -382,6 +471,7 @@ static int set_framesize(sensor_t *sensor, framesize_t framesize)
 {
     int ret = 0;
     framesize_t old_framesize = sensor->status.framesize;
+    uint32_t writes = reg_write_cnt;
     sensor->status.framesize = framesize;
 
     if(framesize > FRAMESIZE_QSXGA){
@@ -453,7 +543,7 @@ static int set_framesize(sensor_t *sensor, framesize_t framesize)
     }
 
     if (ret == 0) {
-        ESP_LOGD(TAG, "Set framesize to: %ux%u", w, h);
+        ESP_LOGD(TAG, "Set framesize to: %ux%u, %u registers written", w, h, (unsigned)(reg_write_cnt - writes));
     }
     return ret;
 
@@ -463,6 +553,40 @@ fail:
     return ret;
 }
 
+/*
+ * Narrow the sensor array window to the rows that scale to [offset_y, offset_y + height)
+ * of the current frame size and shorten VTS by the rows no longer read out, so the
+ * frame period drops along with the bytes per frame. Horizontal settings are untouched.
+ */
+static int set_roi(sensor_t *sensor, int offset_y, int height)
+{
+    int ret = 0;
+    framesize_t framesize = sensor->status.framesize;
+    uint16_t h = resolution[framesize].height;
+    ratio_settings_t settings = ratio_table[resolution[framesize].aspect_ratio];
+
+    if (height <= 0 || (height % 2) || offset_y < 0 || offset_y + height > h) {
+        ESP_LOGE(TAG, "Invalid ROI: y=%d h=%d", offset_y, height);
+        return -1;
+    }
+
+    // rows of the active array, kept even so the Bayer phase does not change
+    int roi_rows = (height * settings.max_height / h) & ~1;
+    int start_y = (settings.start_y + offset_y * settings.max_height / h) & ~1;
+    int end_y = start_y + roi_rows + 2 * settings.offset_y - 1;
+    int total_y = settings.total_y - (settings.max_height - roi_rows);
+
+    ret  = write_addr_reg(sensor->slv_addr, X_ADDR_ST_H, settings.start_x, start_y)
+        || write_addr_reg(sensor->slv_addr, X_ADDR_END_H, settings.end_x, end_y)
+        || write_reg16(sensor->slv_addr, Y_OUTPUT_SIZE_H, height)
+        || write_reg16(sensor->slv_addr, Y_TOTAL_SIZE_H, sensor->status.binning ? total_y / 2 : total_y);
+
+    if (ret == 0) {
+        ESP_LOGD(TAG, "Set ROI to: y=%d h=%d", offset_y, height);
+    }
+    return ret;
+}
+
 static int set_hmirror(sensor_t *sensor, int enable)
 {
     int ret = 0;
@@ -1091,6 +1215,8 @@ int ov5640_detect(int slv_addr, sensor_id_t *id)
 
 int ov5640_init(sensor_t *sensor)
 {
+    // the sensor may have been powered down since the last init
+    reg_shadow_valid = 0;
     sensor->reset = reset;
     sensor->set_pixformat = set_pixformat;
     sensor->set_framesize = set_framesize;
@@ -1124,6 +1250,7 @@ int ov5640_init(sensor_t *sensor)
     sensor->get_reg = get_reg;
     sensor->set_reg = set_reg;
     sensor->set_res_raw = set_res_raw;
+    sensor->set_roi = set_roi;
     sensor->set_pll = _set_pll;
     sensor->set_xclk = set_xclk;
     return 0;
@@ -31,8 +31,10 @@ static inline int gpio_ll_get_level(gpio_dev_t *hw, int gpio_num)
 }
 #endif
 #include "ll_cam.h"
+#include "esp_timer.h"
 #include "xclk.h"
 #include "cam_hal.h"
+#include "ll_cam_dma_filter.h"
 
 #if (ESP_IDF_VERSION_MAJOR >= 4) && (ESP_IDF_VERSION_MINOR >= 3)
 #include "esp_rom_gpio.h"
@@ -54,16 +56,6 @@ static const char *TAG = "esp32 ll_cam";
 #define I2S_ISR_ENABLE(i) {I2S0.int_clr.i = 1;I2S0.int_ena.i = 1;}
 #define I2S_ISR_DISABLE(i) {I2S0.int_ena.i = 0;I2S0.int_clr.i = 1;}
 
-typedef union {
-    struct {
-        uint32_t sample2:8;
-        uint32_t unused2:8;
-        uint32_t sample1:8;
-        uint32_t unused1:8;
-    };
-    uint32_t val;
-} dma_elem_t;
-
 typedef enum {
     /* camera sends byte sequence: s1, s2, s3, s4, ...
      * fifo receives: 00 s1 00 s2, 00 s2 00 s3, 00 s3 00 s4, ...
@@ -79,7 +71,12 @@ typedef enum {
     SM_0A00_0B00 = 3,
 } i2s_sampling_mode_t;
 
-typedef size_t (*dma_filter_t)(uint8_t* dst, const uint8_t* src, size_t len);
+// CONFIG_CAMERA_DMA_FILTER_WORD selects the 32-bit load/merge/store filters
+#if CONFIG_CAMERA_DMA_FILTER_WORD
+#define DMA_FILTER(name) ll_cam_dma_filter_##name##_word
+#else
+#define DMA_FILTER(name) ll_cam_dma_filter_##name
+#endif
 
 static i2s_sampling_mode_t sampling_mode = SM_0A00_0B00;
 
@@ -98,121 +95,16 @@ static size_t ll_cam_bytes_per_sample(i2s_sampling_mode_t mode)
     }
 }
 
-static size_t IRAM_ATTR ll_cam_dma_filter_jpeg(uint8_t* dst, const uint8_t* src, size_t len)
-{
-    const dma_elem_t* dma_el = (const dma_elem_t*)src;
-    size_t elements = len / sizeof(dma_elem_t);
-    size_t end = elements / 4;
-    // manually unrolling 4 iterations of the loop here
-    for (size_t i = 0; i < end; ++i) {
-        dst[0] = dma_el[0].sample1;
-        dst[1] = dma_el[1].sample1;
-        dst[2] = dma_el[2].sample1;
-        dst[3] = dma_el[3].sample1;
-        dma_el += 4;
-        dst += 4;
-    }
-    return elements;
-}
-
-static size_t IRAM_ATTR ll_cam_dma_filter_grayscale(uint8_t* dst, const uint8_t* src, size_t len)
-{
-    const dma_elem_t* dma_el = (const dma_elem_t*)src;
-    size_t elements = len / sizeof(dma_elem_t);
-    size_t end = elements / 4;
-    for (size_t i = 0; i < end; ++i) {
-        // manually unrolling 4 iterations of the loop here
-        dst[0] = dma_el[0].sample1;
-        dst[1] = dma_el[1].sample1;
-        dst[2] = dma_el[2].sample1;
-        dst[3] = dma_el[3].sample1;
-        dma_el += 4;
-        dst += 4;
-    }
-    return elements;
-}
-
-static size_t IRAM_ATTR ll_cam_dma_filter_grayscale_highspeed(uint8_t* dst, const uint8_t* src, size_t len)
-{
-    const dma_elem_t* dma_el = (const dma_elem_t*)src;
-    size_t elements = len / sizeof(dma_elem_t);
-    size_t end = elements / 8;
-    for (size_t i = 0; i < end; ++i) {
-        // manually unrolling 4 iterations of the loop here
-        dst[0] = dma_el[0].sample1;
-        dst[1] = dma_el[2].sample1;
-        dst[2] = dma_el[4].sample1;
-        dst[3] = dma_el[6].sample1;
-        dma_el += 8;
-        dst += 4;
-    }
-    // the final sample of a line in SM_0A0B_0B0C sampling mode needs special handling
-    if ((elements & 0x7) != 0) {
-        dst[0] = dma_el[0].sample1;
-        dst[1] = dma_el[2].sample1;
-        elements += 1;
-    }
-    return elements / 2;
-}
-
-static size_t IRAM_ATTR ll_cam_dma_filter_yuyv(uint8_t* dst, const uint8_t* src, size_t len)
-{
-    const dma_elem_t* dma_el = (const dma_elem_t*)src;
-    size_t elements = len / sizeof(dma_elem_t);
-    size_t end = elements / 4;
-    for (size_t i = 0; i < end; ++i) {
-        dst[0] = dma_el[0].sample1;//y0
-        dst[1] = dma_el[0].sample2;//u
-        dst[2] = dma_el[1].sample1;//y1
-        dst[3] = dma_el[1].sample2;//v
-
-        dst[4] = dma_el[2].sample1;//y0
-        dst[5] = dma_el[2].sample2;//u
-        dst[6] = dma_el[3].sample1;//y1
-        dst[7] = dma_el[3].sample2;//v
-        dma_el += 4;
-        dst += 8;
-    }
-    return elements * 2;
-}
-
-static size_t IRAM_ATTR ll_cam_dma_filter_yuyv_highspeed(uint8_t* dst, const uint8_t* src, size_t len)
-{
-    const dma_elem_t* dma_el = (const dma_elem_t*)src;
-    size_t elements = len / sizeof(dma_elem_t);
-    size_t end = elements / 8;
-    for (size_t i = 0; i < end; ++i) {
-        dst[0] = dma_el[0].sample1;//y0
-        dst[1] = dma_el[1].sample1;//u
-        dst[2] = dma_el[2].sample1;//y1
-        dst[3] = dma_el[3].sample1;//v
-
-        dst[4] = dma_el[4].sample1;//y0
-        dst[5] = dma_el[5].sample1;//u
-        dst[6] = dma_el[6].sample1;//y1
-        dst[7] = dma_el[7].sample1;//v
-        dma_el += 8;
-        dst += 8;
-    }
-    if ((elements & 0x7) != 0) {
-        dst[0] = dma_el[0].sample1;//y0
-        dst[1] = dma_el[1].sample1;//u
-        dst[2] = dma_el[2].sample1;//y1
-        dst[3] = dma_el[2].sample2;//v
-        elements += 4;
-    }
-    return elements;
-}
-
 static void IRAM_ATTR ll_cam_vsync_isr(void *arg)
 {
+    int64_t isr_us = esp_timer_get_time();
     //DBG_PIN_SET(1);
     cam_obj_t *cam = (cam_obj_t *)arg;
     BaseType_t HPTaskAwoken = pdFALSE;
     // filter
     ets_delay_us(1);
     if (gpio_ll_get_level(&GPIO, cam->vsync_pin) == !cam->vsync_invert) {
-        ll_cam_send_event(cam, CAM_VSYNC_EVENT, &HPTaskAwoken);
+        ll_cam_send_event(cam, CAM_VSYNC_EVENT, isr_us, &HPTaskAwoken);
         if (HPTaskAwoken == pdTRUE) {
             portYIELD_FROM_ISR();
         }
@@ -222,6 +114,7 @@ static void IRAM_ATTR ll_cam_vsync_isr(void *arg)
 
 static void IRAM_ATTR ll_cam_dma_isr(void *arg)
 {
+    int64_t isr_us = esp_timer_get_time();
     //DBG_PIN_SET(1);
     cam_obj_t *cam = (cam_obj_t *)arg;
     BaseType_t HPTaskAwoken = pdFALSE;
@@ -234,7 +127,7 @@ static void IRAM_ATTR ll_cam_dma_isr(void *arg)
     I2S0.int_clr.val = status.val;
 
     if (status.in_suc_eof) {
-        ll_cam_send_event(cam, CAM_IN_SUC_EOF_EVENT, &HPTaskAwoken);
+        ll_cam_send_event(cam, CAM_IN_SUC_EOF_EVENT, isr_us, &HPTaskAwoken);
     }
     if (HPTaskAwoken == pdTRUE) {
         portYIELD_FROM_ISR();
@@ -478,7 +371,7 @@ bool ll_cam_dma_sizes(cam_obj_t *cam)
     return 1;
 }
 
-static dma_filter_t dma_filter = ll_cam_dma_filter_jpeg;
+static dma_filter_t dma_filter = DMA_FILTER(jpeg);
 
 size_t IRAM_ATTR ll_cam_memcpy(cam_obj_t *cam, uint8_t *out, const uint8_t *in, size_t len)
 {
@@ -494,19 +387,19 @@ esp_err_t ll_cam_set_sample_mode(cam_obj_t *cam, pixformat_t pix_format, uint32_
         if (sensor_pid == OV3660_PID || sensor_pid == OV5640_PID || sensor_pid == NT99141_PID || sensor_pid == SC031GS_PID || sensor_pid == BF20A6_PID || sensor_pid == GC0308_PID) {
             if (xclk_freq_hz > 10000000) {
                 sampling_mode = SM_0A00_0B00;
-                dma_filter = ll_cam_dma_filter_yuyv_highspeed;
+                dma_filter = DMA_FILTER(yuyv_highspeed);
             } else {
                 sampling_mode = SM_0A0B_0C0D;
-                dma_filter = ll_cam_dma_filter_yuyv;
+                dma_filter = DMA_FILTER(yuyv);
             }
             cam->in_bytes_per_pixel = 1;       // camera sends Y8
         } else {
             if (xclk_freq_hz > 10000000 && sensor_pid != OV7725_PID) {
                 sampling_mode = SM_0A00_0B00;
-                dma_filter = ll_cam_dma_filter_grayscale_highspeed;
+                dma_filter = DMA_FILTER(grayscale_highspeed);
             } else {
                 sampling_mode = SM_0A0B_0C0D;
-                dma_filter = ll_cam_dma_filter_grayscale;
+                dma_filter = DMA_FILTER(grayscale);
             }
             cam->in_bytes_per_pixel = 2;       // camera sends YU/YV
         }
@@ -518,17 +411,17 @@ esp_err_t ll_cam_set_sample_mode(cam_obj_t *cam, pixformat_t pix_format, uint32_
                 } else {
                     sampling_mode = SM_0A00_0B00;
                 }
-                dma_filter = ll_cam_dma_filter_yuyv_highspeed;
+                dma_filter = DMA_FILTER(yuyv_highspeed);
             } else {
                 sampling_mode = SM_0A0B_0C0D;
-                dma_filter = ll_cam_dma_filter_yuyv;
+                dma_filter = DMA_FILTER(yuyv);
             }
             cam->in_bytes_per_pixel = 2;       // camera sends YU/YV
             cam->fb_bytes_per_pixel = 2;       // frame buffer stores YU/YV/RGB565
     } else if (pix_format == PIXFORMAT_JPEG) {
         cam->in_bytes_per_pixel = 1;
         cam->fb_bytes_per_pixel = 1;
-        dma_filter = ll_cam_dma_filter_jpeg;
+        dma_filter = DMA_FILTER(jpeg);
         sampling_mode = SM_0A00_0B00;
     } else {
         ESP_LOGE(TAG, "Requested format is not supported");
@@ -0,0 +1,237 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "esp_attr.h"
+#include "ll_cam_dma_filter.h"
+
+size_t IRAM_ATTR ll_cam_dma_filter_jpeg(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    // manually unrolling 4 iterations of the loop here
+    for (size_t i = 0; i < end; ++i) {
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[1].sample1;
+        dst[2] = dma_el[2].sample1;
+        dst[3] = dma_el[3].sample1;
+        dma_el += 4;
+        dst += 4;
+    }
+    return elements;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_grayscale(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    for (size_t i = 0; i < end; ++i) {
+        // manually unrolling 4 iterations of the loop here
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[1].sample1;
+        dst[2] = dma_el[2].sample1;
+        dst[3] = dma_el[3].sample1;
+        dma_el += 4;
+        dst += 4;
+    }
+    return elements;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_grayscale_highspeed(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 8;
+    for (size_t i = 0; i < end; ++i) {
+        // manually unrolling 4 iterations of the loop here
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[2].sample1;
+        dst[2] = dma_el[4].sample1;
+        dst[3] = dma_el[6].sample1;
+        dma_el += 8;
+        dst += 4;
+    }
+    // the final sample of a line in SM_0A0B_0B0C sampling mode needs special handling
+    if ((elements & 0x7) != 0) {
+        dst[0] = dma_el[0].sample1;
+        dst[1] = dma_el[2].sample1;
+        elements += 1;
+    }
+    return elements / 2;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_yuyv(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    for (size_t i = 0; i < end; ++i) {
+        // sample2 first: when converting in place dst[0] is the byte sample2 is read from
+        dst[1] = dma_el[0].sample2;//u
+        dst[0] = dma_el[0].sample1;//y0
+        dst[3] = dma_el[1].sample2;//v
+        dst[2] = dma_el[1].sample1;//y1
+
+        dst[5] = dma_el[2].sample2;//u
+        dst[4] = dma_el[2].sample1;//y0
+        dst[7] = dma_el[3].sample2;//v
+        dst[6] = dma_el[3].sample1;//y1
+        dma_el += 4;
+        dst += 8;
+    }
+    return elements * 2;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_yuyv_highspeed(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    const dma_elem_t* dma_el = (const dma_elem_t*)src;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 8;
+    for (size_t i = 0; i < end; ++i) {
+        dst[0] = dma_el[0].sample1;//y0
+        dst[1] = dma_el[1].sample1;//u
+        dst[2] = dma_el[2].sample1;//y1
+        dst[3] = dma_el[3].sample1;//v
+
+        dst[4] = dma_el[4].sample1;//y0
+        dst[5] = dma_el[5].sample1;//u
+        dst[6] = dma_el[6].sample1;//y1
+        dst[7] = dma_el[7].sample1;//v
+        dma_el += 8;
+        dst += 8;
+    }
+    if ((elements & 0x7) != 0) {
+        dst[0] = dma_el[0].sample1;//y0
+        dst[1] = dma_el[1].sample1;//u
+        dst[2] = dma_el[2].sample1;//y1
+        dst[3] = dma_el[2].sample2;//v
+        elements += 4;
+    }
+    return elements;
+}
+
+/*
+ * Word-wide versions. sample1 of item e is (e >> 16) & 0xff and sample2 is e & 0xff, so four
+ * sample1 bytes merge into one little-endian output word with three shifts and four masks.
+ * The ESP32 faults on unaligned 32-bit stores; dst is only unaligned after a line whose
+ * length is not a multiple of 4, and those rare calls take the byte path.
+ */
+
+// sample1 of items a, b, c, d as output bytes 0..3
+static inline uint32_t pack_sample1(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    return ((a >> 16) & 0xffu) | ((b >> 8) & 0xff00u) | (c & 0xff0000u) | ((d << 8) & 0xff000000u);
+}
+
+// sample1, sample2 of item a, then of item b
+static inline uint32_t pack_yuyv(uint32_t a, uint32_t b)
+{
+    return ((a >> 16) & 0xffu) | ((a << 8) & 0xff00u) | (b & 0xff0000u) | (b << 24);
+}
+
+static inline int dst_unaligned(const uint8_t* dst)
+{
+    return ((uintptr_t)dst & 3) != 0;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_grayscale_word(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    if (dst_unaligned(dst)) {
+        return ll_cam_dma_filter_grayscale(dst, src, len);
+    }
+    const uint32_t* in = (const uint32_t*)src;
+    uint32_t* out = (uint32_t*)dst;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    for (size_t i = 0; i < end; ++i) {
+        out[i] = pack_sample1(in[0], in[1], in[2], in[3]);
+        in += 4;
+    }
+    return elements;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_jpeg_word(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    // JPEG bytes sit in the same place as grayscale samples
+    return ll_cam_dma_filter_grayscale_word(dst, src, len);
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_grayscale_highspeed_word(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    if (dst_unaligned(dst)) {
+        return ll_cam_dma_filter_grayscale_highspeed(dst, src, len);
+    }
+    const uint32_t* in = (const uint32_t*)src;
+    uint32_t* out = (uint32_t*)dst;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 8;
+    for (size_t i = 0; i < end; ++i) {
+        out[i] = pack_sample1(in[0], in[2], in[4], in[6]);
+        in += 8;
+    }
+    if ((elements & 0x7) != 0) {
+        dst += end * 4;
+        dst[0] = (in[0] >> 16) & 0xff;
+        dst[1] = (in[2] >> 16) & 0xff;
+        elements += 1;
+    }
+    return elements / 2;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_yuyv_word(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    if (dst_unaligned(dst)) {
+        return ll_cam_dma_filter_yuyv(dst, src, len);
+    }
+    const uint32_t* in = (const uint32_t*)src;
+    uint32_t* out = (uint32_t*)dst;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 4;
+    for (size_t i = 0; i < end; ++i) {
+        // read all four items before the first store, in-place output overlaps the first item
+        uint32_t a = in[0], b = in[1], c = in[2], d = in[3];
+        out[0] = pack_yuyv(a, b);
+        out[1] = pack_yuyv(c, d);
+        in += 4;
+        out += 2;
+    }
+    return elements * 2;
+}
+
+size_t IRAM_ATTR ll_cam_dma_filter_yuyv_highspeed_word(uint8_t* dst, const uint8_t* src, size_t len)
+{
+    if (dst_unaligned(dst)) {
+        return ll_cam_dma_filter_yuyv_highspeed(dst, src, len);
+    }
+    const uint32_t* in = (const uint32_t*)src;
+    uint32_t* out = (uint32_t*)dst;
+    size_t elements = len / sizeof(dma_elem_t);
+    size_t end = elements / 8;
+    for (size_t i = 0; i < end; ++i) {
+        out[0] = pack_sample1(in[0], in[1], in[2], in[3]);
+        out[1] = pack_sample1(in[4], in[5], in[6], in[7]);
+        in += 8;
+        out += 2;
+    }
+    if ((elements & 0x7) != 0) {
+        dst += end * 8;
+        dst[0] = (in[0] >> 16) & 0xff;//y0
+        dst[1] = (in[1] >> 16) & 0xff;//u
+        dst[2] = (in[2] >> 16) & 0xff;//y1
+        dst[3] = in[2] & 0xff;//v
+        elements += 4;
+    }
+    return elements;
+}
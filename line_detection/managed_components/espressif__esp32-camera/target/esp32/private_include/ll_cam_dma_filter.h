@@ -0,0 +1,66 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief One I2S DMA item as the ESP32 camera mode stores it: every camera byte lands in its own
+ * 32-bit word, sample1 in bits 16..23 and (in the YUYV modes) sample2 in bits 0..7
+ */
+typedef union {
+    struct {
+        uint32_t sample2:8;
+        uint32_t unused2:8;
+        uint32_t sample1:8;
+        uint32_t unused1:8;
+    };
+    uint32_t val;
+} dma_elem_t;
+
+/**
+ * @brief Extract the camera bytes from a DMA half-buffer
+ *
+ * @param dst  Output, may alias src (the output never runs ahead of the input)
+ * @param src  DMA items, 4-byte aligned
+ * @param len  Input length in bytes
+ *
+ * @return Output length in bytes
+ */
+typedef size_t (*dma_filter_t)(uint8_t* dst, const uint8_t* src, size_t len);
+
+// Byte at a time, one dma_elem_t bitfield read and one byte store per output byte
+size_t ll_cam_dma_filter_jpeg(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_grayscale(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_grayscale_highspeed(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_yuyv(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_yuyv_highspeed(uint8_t* dst, const uint8_t* src, size_t len);
+
+// Word at a time: 32-bit loads, shift/mask merge, one 32-bit store per 4 output bytes.
+// Same output as the byte versions for any input; an unaligned dst falls back to them.
+size_t ll_cam_dma_filter_jpeg_word(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_grayscale_word(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_grayscale_highspeed_word(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_yuyv_word(uint8_t* dst, const uint8_t* src, size_t len);
+size_t ll_cam_dma_filter_yuyv_highspeed_word(uint8_t* dst, const uint8_t* src, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
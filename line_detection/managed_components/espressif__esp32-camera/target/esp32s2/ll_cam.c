@@ -18,6 +18,7 @@
 #include "soc/i2s_struct.h"
 #include "hal/gpio_ll.h"
 #include "ll_cam.h"
+#include "esp_timer.h"
 #include "xclk.h"
 #include "cam_hal.h"
 
@@ -40,13 +41,14 @@ static const char *TAG = "s2 ll_cam";
 
 static void CAMERA_ISR_IRAM_ATTR ll_cam_vsync_isr(void *arg)
 {
+    int64_t isr_us = esp_timer_get_time();
     //DBG_PIN_SET(1);
     cam_obj_t *cam = (cam_obj_t *)arg;
     BaseType_t HPTaskAwoken = pdFALSE;
     // filter
     ets_delay_us(1);
     if (gpio_ll_get_level(&GPIO, cam->vsync_pin) == !cam->vsync_invert) {
-        ll_cam_send_event(cam, CAM_VSYNC_EVENT, &HPTaskAwoken);
+        ll_cam_send_event(cam, CAM_VSYNC_EVENT, isr_us, &HPTaskAwoken);
     }
 
     if (HPTaskAwoken == pdTRUE) {
@@ -57,6 +59,7 @@ static void CAMERA_ISR_IRAM_ATTR ll_cam_vsync_isr(void *arg)
 
 static void CAMERA_ISR_IRAM_ATTR ll_cam_dma_isr(void *arg)
 {
+    int64_t isr_us = esp_timer_get_time();
     cam_obj_t *cam = (cam_obj_t *)arg;
     BaseType_t HPTaskAwoken = pdFALSE;
 
@@ -68,7 +71,7 @@ static void CAMERA_ISR_IRAM_ATTR ll_cam_dma_isr(void *arg)
     I2S0.int_clr.val = status.val;
 
     if (status.in_suc_eof) {
-        ll_cam_send_event(cam, CAM_IN_SUC_EOF_EVENT, &HPTaskAwoken);
+        ll_cam_send_event(cam, CAM_IN_SUC_EOF_EVENT, isr_us, &HPTaskAwoken);
     }
 
     if (HPTaskAwoken == pdTRUE) {
@@ -384,8 +387,11 @@ size_t IRAM_ATTR ll_cam_memcpy(cam_obj_t *cam, uint8_t *out, const uint8_t *in,
         return len / 2;
     }
 
-    // just memcpy
-    memcpy(out, in, len);
+    // just copy, nothing to do when converting in place; cropped rows are compacted
+    // towards the start of the same buffer, so source and destination may overlap
+    if (out != in) {
+        memmove(out, in, len);
+    }
     return len;
 }
 
@@ -23,7 +23,9 @@
 #include "hal/clk_gate_ll.h"
 #include "esp_private/gdma.h"
 #include "ll_cam.h"
+#include "esp_timer.h"
 #include "cam_hal.h"
+#include "ll_cam_luma.h"
 #include "esp_rom_gpio.h"
 
 #if (ESP_IDF_VERSION_MAJOR >= 5)
@@ -92,6 +94,7 @@ void ll_cam_dma_reset(cam_obj_t *cam)
 
 static void CAMERA_ISR_IRAM_ATTR ll_cam_vsync_isr(void *arg)
 {
+    int64_t isr_us = esp_timer_get_time();
     //DBG_PIN_SET(1);
     cam_obj_t *cam = (cam_obj_t *)arg;
     BaseType_t HPTaskAwoken = pdFALSE;
@@ -104,7 +107,7 @@ static void CAMERA_ISR_IRAM_ATTR ll_cam_vsync_isr(void *arg)
     LCD_CAM.lc_dma_int_clr.val = status.val;
 
     if (status.cam_vsync_int_st) {
-        ll_cam_send_event(cam, CAM_VSYNC_EVENT, &HPTaskAwoken);
+        ll_cam_send_event(cam, CAM_VSYNC_EVENT, isr_us, &HPTaskAwoken);
     }
 
     if (HPTaskAwoken == pdTRUE) {
@@ -115,6 +118,7 @@ static void CAMERA_ISR_IRAM_ATTR ll_cam_vsync_isr(void *arg)
 
 static void CAMERA_ISR_IRAM_ATTR ll_cam_dma_isr(void *arg)
 {
+    int64_t isr_us = esp_timer_get_time();
     cam_obj_t *cam = (cam_obj_t *)arg;
     BaseType_t HPTaskAwoken = pdFALSE;
 
@@ -126,7 +130,7 @@ static void CAMERA_ISR_IRAM_ATTR ll_cam_dma_isr(void *arg)
     GDMA.channel[cam->dma_num].in.int_clr.val = status.val;
 
     if (status.in_suc_eof) {
-        ll_cam_send_event(cam, CAM_IN_SUC_EOF_EVENT, &HPTaskAwoken);
+        ll_cam_send_event(cam, CAM_IN_SUC_EOF_EVENT, isr_us, &HPTaskAwoken);
     }
 
     if (HPTaskAwoken == pdTRUE) {
@@ -136,7 +140,7 @@ static void CAMERA_ISR_IRAM_ATTR ll_cam_dma_isr(void *arg)
 
 bool IRAM_ATTR ll_cam_stop(cam_obj_t *cam)
 {
-    if (cam->jpeg_mode || !cam->psram_mode) {
+    if (cam->jpeg_mode || !cam->psram_mode || cam->psram_luma) {
         GDMA.channel[cam->dma_num].in.int_ena.in_suc_eof = 0;
         GDMA.channel[cam->dma_num].in.int_clr.in_suc_eof = 1;
     }
@@ -148,7 +152,7 @@ bool ll_cam_start(cam_obj_t *cam, int frame_pos)
 {
     LCD_CAM.cam_ctrl1.cam_start = 0;
 
-    if (cam->jpeg_mode || !cam->psram_mode) {
+    if (cam->jpeg_mode || !cam->psram_mode || cam->psram_luma) {
         GDMA.channel[cam->dma_num].in.int_clr.in_suc_eof = 1;
         GDMA.channel[cam->dma_num].in.int_ena.in_suc_eof = 1;
     }
@@ -538,20 +542,14 @@ size_t IRAM_ATTR ll_cam_memcpy(cam_obj_t *cam, uint8_t *out, const uint8_t *in,
 {
     // YUV to Grayscale
     if (cam->in_bytes_per_pixel == 2 && cam->fb_bytes_per_pixel == 1) {
-        size_t end = len / 8;
-        for (size_t i = 0; i < end; ++i) {
-            out[0] = in[0];
-            out[1] = in[2];
-            out[2] = in[4];
-            out[3] = in[6];
-            out += 4;
-            in += 8;
-        }
-        return len / 2;
+        return ll_cam_yuyv_to_y(out, in, len);
     }
 
-    // just memcpy
-    memcpy(out, in, len);
+    // just copy, nothing to do when converting in place; cropped rows are compacted
+    // towards the start of the same buffer, so source and destination may overlap
+    if (out != in) {
+        memmove(out, in, len);
+    }
     return len;
 }
 
@@ -0,0 +1,63 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "esp_attr.h"
+#include "ll_cam_luma.h"
+
+size_t IRAM_ATTR ll_cam_yuyv_to_y_bytes(uint8_t *out, const uint8_t *in, size_t len)
+{
+    size_t end = len / 8;
+    for (size_t i = 0; i < end; ++i) {
+        out[0] = in[0];
+        out[1] = in[2];
+        out[2] = in[4];
+        out[3] = in[6];
+        out += 4;
+        in += 8;
+    }
+    return len / 2;
+}
+
+/*
+ * Two little-endian input words y0 u y1 v | y2 v y3 u hold four Y bytes in their even lanes;
+ * shift and mask them into one output word. 16 input bytes per iteration, two loads and one
+ * store per 4 output bytes instead of four of each, paid for with about ten ALU operations.
+ * Whether that wins on the single-issue LX7 is measured by the [luma] case in test/test_camera.c.
+ */
+static inline uint32_t even_bytes(uint32_t a, uint32_t b)
+{
+    return (a & 0xffu) | ((a >> 8) & 0xff00u) | ((b << 16) & 0xff0000u) | ((b << 8) & 0xff000000u);
+}
+
+size_t IRAM_ATTR ll_cam_yuyv_to_y(uint8_t *out, const uint8_t *in, size_t len)
+{
+    if (((uintptr_t)out | (uintptr_t)in) & 3) {
+        return ll_cam_yuyv_to_y_bytes(out, in, len);
+    }
+    const uint32_t *src = (const uint32_t *)in;
+    uint32_t *dst = (uint32_t *)out;
+    size_t end = len / 16;
+    for (size_t i = 0; i < end; ++i) {
+        // load before store: in place, dst[0] is src[0]
+        uint32_t a = src[0], b = src[1], c = src[2], d = src[3];
+        dst[0] = even_bytes(a, b);
+        dst[1] = even_bytes(c, d);
+        src += 4;
+        dst += 2;
+    }
+    if (len & 8) {
+        dst[0] = even_bytes(src[0], src[1]);
+    }
+    return len / 2;
+}
@@ -0,0 +1,45 @@
+// Copyright 2010-2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Keep the Y bytes of a YUYV (or YVYU) stream: out[i] = in[2 * i]
+ *
+ * Only whole groups of 8 input bytes are converted, the return value still counts len / 2
+ * like the rest of the capture path expects.
+ *
+ * @param out  Output, may alias in (the output never runs ahead of the input)
+ * @param in   YUYV bytes
+ * @param len  Input length in bytes
+ *
+ * @return len / 2
+ */
+size_t ll_cam_yuyv_to_y(uint8_t *out, const uint8_t *in, size_t len);
+
+/**
+ * @brief Byte-at-a-time reference for ll_cam_yuyv_to_y(), also used when out or in is not 4-byte aligned
+ */
+size_t ll_cam_yuyv_to_y_bytes(uint8_t *out, const uint8_t *in, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdatomic.h>
 #include "sdkconfig.h"
 #include "esp_idf_version.h"
 #if CONFIG_IDF_TARGET_ESP32
@@ -77,20 +78,33 @@
 
 typedef enum {
     CAM_IN_SUC_EOF_EVENT = 0,
-    CAM_VSYNC_EVENT
+    CAM_VSYNC_EVENT,
+    CAM_STOP_SYNC_EVENT         //queued by cam_reconfig() after cam_stop(), cam_task answers on stop_sync
 } cam_event_t;
 
+//event queue item: the ISR stamps the event on entry so cam_task scheduling delay does not leak into frame times
+typedef struct {
+    cam_event_t type;
+    uint32_t seq;               //VSYNC count, valid for CAM_VSYNC_EVENT
+    int64_t us;                 //esp_timer_get_time() at ISR entry
+} cam_event_msg_t;
+
 typedef enum {
     CAM_STATE_IDLE = 0,
     CAM_STATE_READ_BUF = 1,
 } cam_state_t;
 
+//fb must stay first: the driver maps a camera_fb_t * back to its slot by pointer arithmetic
 typedef struct {
     camera_fb_t fb;
-    uint8_t en;
     //for RGB/YUV modes
     lldesc_t *dma;
     size_t fb_offset;
+    //latency tracing, esp_timer time in us
+    int64_t vsync_us;
+    int64_t eof_us;
+    int64_t take_us;
+    int64_t queued_us;
 } cam_frame_t;
 
 typedef struct {
@@ -107,10 +121,14 @@ typedef struct {
     uint8_t  *dma_buffer;
 
     cam_frame_t *frames;
+    //bit x set: frames[x] is owned by the driver and may be captured into
+    //cleared by cam_task before a frame is queued, set again by cam_give() from any task or core
+    _Atomic uint32_t free_mask;
 
     QueueHandle_t event_queue;
     QueueHandle_t frame_buffer_queue;
     TaskHandle_t task_handle;
+    SemaphoreHandle_t stop_sync;
     intr_handle_t cam_intr_handle;
 
     uint8_t dma_num;//ESP32-S3
@@ -126,6 +144,7 @@ typedef struct {
     uint32_t recv_size;
     bool swap_data;
     bool psram_mode;
+    bool psram_luma;            //PSRAM YUYV to GRAYSCALE: Y is extracted in place after every EOF (ESP32-S3)
 
     //for RGB/YUV modes
     uint16_t width;
@@ -139,8 +158,34 @@ typedef struct {
     uint8_t fb_bytes_per_pixel;
 #endif
     uint32_t fb_size;
+    //frame buffer geometry after crop_x / crop_width / row_step, width x height when not cropping
+    uint16_t fb_width;
+    uint16_t fb_height;
+    uint16_t crop_x;
+    uint8_t row_step;
+    bool cropped;
+    uint32_t crop_row;          //sensor row of the next line cam_task copies
+    bool fb_external;           //frame buffers come from camera_config_t::fb_pool, not freed by cam_deinit()
+
+    //what was allocated at cam_config(), cam_reconfig() reuses it for any frame that fits
+    uint32_t dma_buffer_cap;
+    uint32_t dma_node_cap;
+    uint32_t fb_cap;
+    uint32_t event_queue_cap;
 
     cam_state_t state;
+
+    //VSYNC count, only written from the VSYNC ISR
+    volatile uint32_t vsync_cnt;
+
+    //drop and queue counters, see esp_camera_get_stats()
+    camera_stats_t stats;
+
+    //row slices handed to the app from cam_task while the frame is captured
+    camera_slice_cb_t slice_cb;
+    void *slice_arg;
+    bool slice_only;            //no frame buffers, slices are converted in place in the DMA buffer
+    uint32_t slice_frame;
 } cam_obj_t;
 
 
@@ -162,4 +207,4 @@ void ll_cam_dma_reset(cam_obj_t *cam);
 #endif
 
 // implemented in cam_hal
-void ll_cam_send_event(cam_obj_t *cam, cam_event_t cam_event, BaseType_t * HPTaskAwoken);
+void ll_cam_send_event(cam_obj_t *cam, cam_event_t cam_event, int64_t isr_us, BaseType_t * HPTaskAwoken);
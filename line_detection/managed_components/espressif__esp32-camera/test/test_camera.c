@@ -10,6 +10,11 @@
 #include "esp_timer.h"
 
 #include "esp_camera.h"
+#if CONFIG_IDF_TARGET_ESP32S3
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "ll_cam_luma.h"
+#endif
 
 #ifdef CONFIG_IDF_TARGET_ESP32
 #define BOARD_WROVER_KIT 1
@@ -535,3 +540,53 @@ TEST_CASE("Camera driver uses an i2c port initialized by other devices test", "[
     TEST_ESP_OK(esp_camera_deinit());
     TEST_ESP_OK(i2c_driver_delete(I2C_MASTER_NUM));
 }
+
+#if CONFIG_IDF_TARGET_ESP32S3
+typedef size_t (*luma_func_t)(uint8_t *out, const uint8_t *in, size_t len);
+
+static uint32_t luma_cycles(luma_func_t fn, uint8_t *out, const uint8_t *in, size_t len, int rounds)
+{
+    uint32_t best = UINT32_MAX;
+    for (int r = 0; r < rounds; r++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        fn(out, in, len);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    return best;
+}
+
+static void luma_cycles_test(uint32_t caps, const char *where)
+{
+    // one DMA half-buffer of QVGA YUYV, the unit ll_cam_memcpy() converts
+    const size_t len = 320 * 2 * 12;
+    uint8_t *in = heap_caps_aligned_alloc(4, len, caps);
+    uint8_t *out_byte = heap_caps_aligned_alloc(4, len / 2, caps);
+    uint8_t *out_word = heap_caps_aligned_alloc(4, len / 2, caps);
+    TEST_ASSERT(in && out_byte && out_word);
+    for (size_t i = 0; i < len; i++) {
+        in[i] = (uint8_t)(i * 7 + (i >> 3));
+    }
+
+    uint32_t byte_cycles = luma_cycles(ll_cam_yuyv_to_y_bytes, out_byte, in, len, 16);
+    uint32_t word_cycles = luma_cycles(ll_cam_yuyv_to_y, out_word, in, len, 16);
+    TEST_ASSERT_EQUAL_MEMORY(out_byte, out_word, len / 2);
+    ESP_LOGI(TAG, "YUYV->Y %s, %u bytes: byte loop %u cycles (%.2f/B), word %u cycles (%.2f/B)", where,
+             (unsigned)len, (unsigned)byte_cycles, (float)byte_cycles / len,
+             (unsigned)word_cycles, (float)word_cycles / len);
+
+    heap_caps_free(in);
+    heap_caps_free(out_byte);
+    heap_caps_free(out_word);
+}
+
+TEST_CASE("YUYV luma extraction cycles, word vs byte loop", "[camera][luma]")
+{
+    luma_cycles_test(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, "internal RAM");
+    if (heap_caps_get_free_size(MALLOC_CAP_SPIRAM)) {
+        luma_cycles_test(MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT, "PSRAM");
+    }
+}
+#endif